@@ -0,0 +1,584 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "ClassSynth.h"
+#include "ClassFile.h"
+#include "Diagnostics.h"
+#include "FileUtils.h"
+#include "JDecomqiler.h"
+#include "Json.h"
+#include "Stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <unistd.h>
+
+using namespace std;
+
+#ifndef JDQ_BUILD
+#define JDQ_BUILD "plain"
+#endif
+
+namespace {
+
+struct Scenario
+{
+	const char * name;
+	unsigned classes;
+	SynthOptions options;
+};
+
+std::vector<Scenario> scenarios()
+{
+	std::vector<Scenario> list;
+	
+	Scenario plain = {"default", 200, SynthOptions()};
+	list.push_back(plain);
+	
+	Scenario pool = {"large_constant_pool", 20, SynthOptions()};
+	pool.options.constants = 20000;
+	list.push_back(pool);
+	
+	Scenario longMethods = {"long_methods", 10, SynthOptions()};
+	longMethods.options.methodLength = 16000;
+	list.push_back(longMethods);
+	
+	Scenario branchy = {"branchy", 100, SynthOptions()};
+	branchy.options.branchPercent = 50;
+	branchy.options.nesting = 6;
+	list.push_back(branchy);
+	
+	Scenario switches = {"switches", 50, SynthOptions()};
+	switches.options.switchCases = 500;
+	list.push_back(switches);
+	
+	Scenario manyMethods = {"many_methods", 4, SynthOptions()};
+	manyMethods.options.methods = 4000;
+	list.push_back(manyMethods);
+	
+	return list;
+}
+
+struct StageResult
+{
+	std::uint64_t classes = 0;
+	std::uint64_t bytes = 0;
+	double seconds = 0;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// runs pass() over the whole set until minSeconds have passed
+template<typename Pass>
+StageResult measure(double minSeconds, Pass pass)
+{
+	StageResult result;
+	auto start = Clock::now();
+	do
+	{
+		std::uint64_t classes = 0;
+		result.bytes += pass(classes);
+		result.classes += classes;
+		result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	}
+	while(result.seconds < minSeconds);
+	return result;
+}
+
+// first figure of each "scenario/stage" in a previous results file: classes
+// per second, or allocations per class
+typedef std::map<std::string, double> Baseline;
+
+// only reads what writeStage() writes, one stage per line
+bool readBaseline(const char * path, Baseline & baseline)
+{
+	std::ifstream file(path);
+	if(!file.is_open())
+		return false;
+	
+	std::string line, scenario;
+	while(std::getline(file, line))
+	{
+		std::size_t name = line.find("\"name\": \"");
+		if(name != std::string::npos)
+		{
+			name += 9;
+			scenario = line.substr(name, line.find('"', name) - name);
+			continue;
+		}
+		
+		// "<stage>": {"<first figure>": value, ...
+		std::size_t figures = line.find("\": {\"");
+		std::size_t stage = line.find('"');
+		if(figures == std::string::npos || stage >= figures)
+			continue;
+		std::size_t value = line.find("\": ", figures + 5);
+		if(value == std::string::npos)
+			continue;
+		std::string stageName = line.substr(stage + 1, figures - stage - 1);
+		baseline[scenario + "/" + stageName] = std::atof(line.c_str() + value + 3);
+	}
+	return true;
+}
+
+void writeStage(std::ostream & out, const std::string & scenario, const char * name, const StageResult & result, const Baseline & baseline, bool last)
+{
+	double rate = result.classes / result.seconds;
+	out << "        \"" << name << "\": {\"classes_per_sec\": " << rate
+	    << ", \"bytes_per_sec\": " << result.bytes / result.seconds
+	    << ", \"ns_per_class\": " << result.seconds * 1e9 / result.classes;
+	
+	auto base = baseline.find(scenario + "/" + name);
+	if(base != baseline.end() && base->second > 0)
+		out << ", \"speedup\": " << rate / base->second;
+	out << "}" << (last ? "\n" : ",\n");
+}
+
+// classes of growing size for each construct that could make the
+// decompiler super-linear; a construct only belongs here once it is
+// decompiled, timing what is skipped guards nothing
+struct Shape
+{
+	const char * name;
+	std::vector<unsigned> sizes;
+	std::size_t bytesPerUnit; // of Java written at least, per unit of size
+	void (*apply)(SynthOptions & options, unsigned size);
+};
+
+// of Java written at least for any class, the skeleton of the class and of its method
+const std::size_t MIN_OUTPUT_BYTES = 256;
+
+std::vector<Shape> shapes()
+{
+	std::vector<Shape> list;
+	list.push_back({"constant_pool", {8192, 16384, 32768, 65535}, 0, [](SynthOptions & options, unsigned size) {
+		options.constants = size;
+	}});
+	list.push_back({"method_length", {8192, 16384, 32768, 65000}, 2, [](SynthOptions & options, unsigned size) {
+		options.methodLength = size;
+	}});
+	list.push_back({"nested_ifs", {125, 250, 500, 1000}, 16, [](SynthOptions & options, unsigned size) {
+		options.methodLength = 5; // a single statement
+		options.branchPercent = 100;
+		options.nesting = size;
+	}});
+	list.push_back({"append_chain", {1250, 2500, 5000, 10000}, 8, [](SynthOptions & options, unsigned size) {
+		options.appendChain = size;
+	}});
+	return list;
+}
+
+// best time of a decompile() of the class, in seconds; the status and the
+// size of the output of the last run in status and bytes
+double decompileTime(const std::vector<std::uint8_t> & data, DecompileStatus & status, std::size_t & bytes)
+{
+	DecompileOptions options;
+	double best = 0;
+	double total = 0;
+	for(int runs = 0;runs < 3 || total < 0.2;runs++)
+	{
+		auto start = Clock::now();
+		StringSink sink;
+		status = decompile(data.data(), data.size(), options, sink);
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		best = runs == 0 ? seconds : std::min(best, seconds);
+		total += seconds;
+		bytes = sink.text.size();
+	}
+	return best;
+}
+
+// fits time = a * size^exponent over all sizes and fails the shapes whose
+// exponent is above maxExponent (1 is linear, 2 quadratic)
+int runScaling(std::ostream & json, double maxExponent)
+{
+	int failures = 0;
+	json << "{\n  \"version\": \"" JDECOMQILER_VERSION "\",\n  \"build\": \"" JDQ_BUILD "\",\n  \"max_exponent\": " << maxExponent << ",\n  \"shapes\": [\n";
+	bool first = true;
+	for(const Shape & shape : shapes())
+	{
+		std::vector<double> x, y;
+		bool decompiled = true;
+		json << (first ? "" : ",\n") << "    {\"name\": \"" << shape.name << "\", \"points\": [";
+		for(std::size_t i = 0;i < shape.sizes.size();i++)
+		{
+			SynthOptions options;
+			options.methods = 1;
+			options.methodLength = 64;
+			options.branchPercent = 0;
+			shape.apply(options, shape.sizes[i]);
+			
+			DecompileStatus status;
+			std::size_t bytes;
+			double seconds = decompileTime(synthesizeClass("Scaling", options), status, bytes);
+			x.push_back(std::log(static_cast<double>(shape.sizes[i])));
+			y.push_back(std::log(std::max(seconds, 1e-9)));
+			json << (i ? ", " : "") << "{\"size\": " << shape.sizes[i] << ", \"seconds\": " << seconds << ", \"bytes\": " << bytes << "}";
+			cerr << shape.name << " " << shape.sizes[i] << ": " << seconds * 1e3 << " ms, " << bytes << " bytes" << endl;
+			
+			// a fast decompile which failed, or dropped the construct, proves nothing
+			if(status != DECOMPILE_OK || bytes < MIN_OUTPUT_BYTES + shape.bytesPerUnit * shape.sizes[i])
+			{
+				cerr << shape.name << " " << shape.sizes[i] << ": not decompiled (status " << status << ", " << bytes << " bytes)" << endl;
+				decompiled = false;
+			}
+		}
+		
+		double meanX = 0, meanY = 0;
+		for(std::size_t i = 0;i < x.size();i++)
+		{
+			meanX += x[i] / x.size();
+			meanY += y[i] / y.size();
+		}
+		double covariance = 0, variance = 0;
+		for(std::size_t i = 0;i < x.size();i++)
+		{
+			covariance += (x[i] - meanX) * (y[i] - meanY);
+			variance += (x[i] - meanX) * (x[i] - meanX);
+		}
+		double exponent = covariance / variance;
+		bool ok = exponent <= maxExponent && decompiled;
+		if(!ok)
+			failures++;
+		
+		json << "], \"exponent\": " << exponent << ", \"decompiled\": " << (decompiled ? "true" : "false") << ", \"ok\": " << (ok ? "true" : "false") << "}";
+		cerr << shape.name << ": exponent " << exponent << (exponent <= maxExponent ? "" : ", above the limit") << endl;
+		first = false;
+	}
+	json << "\n  ]\n}\n";
+	return failures;
+}
+
+std::vector<std::vector<std::uint8_t>> synthesizeScenario(const Scenario & scenario, const char * dump)
+{
+	std::vector<std::vector<std::uint8_t>> classes;
+	for(unsigned i = 0;i < scenario.classes;i++)
+	{
+		SynthOptions options = scenario.options;
+		options.seed = i + 1;
+		std::string name = std::string("bench/") + scenario.name + "/C" + std::to_string(i);
+		classes.push_back(synthesizeClass(name, options));
+		
+		if(dump)
+		{
+			std::string path = std::string(dump) + "/" + name + ".class";
+			makeDirectories(path.substr(0, path.rfind('/')));
+			writeFile(path, std::string(classes.back().begin(), classes.back().end()));
+		}
+	}
+	return classes;
+}
+
+// valid classes on which the decoder once reported errors
+std::vector<Scenario> regressions()
+{
+	std::vector<Scenario> list;
+	
+	// the object of the constructor was counted as popped, when new
+	// doesn't push it
+	Scenario newObject = {"new_object", 1, SynthOptions()};
+	newObject.options.newObjects = 3;
+	list.push_back(newObject);
+	
+	return list;
+}
+
+// decompiles the regression classes with the error diagnostics on, and
+// fails those which aren't DECOMPILE_OK or report anything
+int runChecks()
+{
+	int failures = 0;
+	std::ostringstream diagnostics;
+	setDiagnosticsOutput(&diagnostics);
+	setDiagnosticsLevel(DIAG_ERROR);
+	for(const Scenario & scenario : regressions())
+	{
+		bool ok = true;
+		DecompileOptions options;
+		for(const auto & data : synthesizeScenario(scenario, nullptr))
+		{
+			StringSink sink;
+			DecompileStatus status = decompile(data.data(), data.size(), options, sink);
+			flushDiagnostics();
+			if(status != DECOMPILE_OK || !diagnostics.str().empty())
+			{
+				ok = false;
+				cerr << diagnostics.str();
+				diagnostics.str("");
+			}
+		}
+		if(!ok)
+			failures++;
+		cerr << scenario.name << ": " << (ok ? "ok" : "failed") << endl;
+	}
+	setDiagnosticsLevel(DIAG_OFF);
+	setDiagnosticsOutput(&std::cerr);
+	return failures;
+}
+
+void writeAllocations(std::ostream & out, const std::string & scenario, const char * name, std::uint64_t allocations, std::uint64_t bytes, std::uint64_t classes, const Baseline & baseline, bool last)
+{
+	double perClass = static_cast<double>(allocations) / classes;
+	out << "        \"" << name << "\": {\"allocations_per_class\": " << perClass
+	    << ", \"bytes_per_class\": " << static_cast<double>(bytes) / classes;
+	
+	auto base = baseline.find(scenario + "/" + name);
+	if(base != baseline.end() && perClass > 0)
+		out << ", \"reduction\": " << base->second / perClass;
+	out << "}" << (last ? "\n" : ",\n");
+}
+
+// what a single decompile() of each class allocates, seen by the hooks of
+// src/AllocHooks.cpp; the counts don't vary between runs, one is enough
+void runAllocations(std::ostream & json, const char * only, const Baseline & baseline)
+{
+	json << "{\n  \"version\": \"" JDECOMQILER_VERSION "\",\n  \"build\": \"" JDQ_BUILD "\",\n  \"scenarios\": [\n";
+	bool first = true;
+	for(const Scenario & scenario : scenarios())
+	{
+		if(only && std::strcmp(only, scenario.name) != 0)
+			continue;
+		
+		std::vector<std::vector<std::uint8_t>> classes = synthesizeScenario(scenario, nullptr);
+		ClassStats stats;
+		DecompileOptions options;
+		for(const auto & data : classes)
+		{
+			STATS_SCOPE(&stats);
+			StringSink sink;
+			decompile(data.data(), data.size(), options, sink);
+		}
+		
+		const std::uint64_t count = classes.size();
+		const std::uint64_t * allocations = stats.stageAllocations;
+		const std::uint64_t * bytes = stats.stageAllocatedBytes;
+		json << (first ? "" : ",\n") << "    {\n      \"name\": ";
+		writeJsonString(json, scenario.name);
+		json << ",\n      \"classes\": " << count << ",\n      \"stages\": {\n";
+		writeAllocations(json, scenario.name, "parse", allocations[STAGE_CONSTANT_POOL] + allocations[STAGE_MEMBERS], bytes[STAGE_CONSTANT_POOL] + bytes[STAGE_MEMBERS], count, baseline, false);
+		writeAllocations(json, scenario.name, "decode", allocations[STAGE_DECODE], bytes[STAGE_DECODE], count, baseline, false);
+		writeAllocations(json, scenario.name, "control_flow", allocations[STAGE_CONTROL_FLOW], bytes[STAGE_CONTROL_FLOW], count, baseline, false);
+		writeAllocations(json, scenario.name, "emit", allocations[STAGE_EMIT], bytes[STAGE_EMIT], count, baseline, false);
+		writeAllocations(json, scenario.name, "decompile", stats.counters[COUNTER_ALLOCATIONS], stats.counters[COUNTER_ALLOCATED_BYTES], count, baseline, true);
+		json << "      }\n    }";
+		cerr << scenario.name << ": " << static_cast<double>(stats.counters[COUNTER_ALLOCATIONS]) / count << " allocations per class" << endl;
+		first = false;
+	}
+	json << "\n  ]\n}\n";
+}
+
+int usage(const char * name)
+{
+	cerr << "usage: " << name << " [-o <results.json>] [-t <seconds per stage>] [-s <scenario>] [--baseline <results.json>] [--dump <dir>]\n"
+	     << "       " << name << " --scaling [--max-exponent <e>] [-o <results.json>]\n"
+	     << "       " << name << " --allocations [-s <scenario>] [--baseline <results.json>] [-o <results.json>]\n"
+	     << "       " << name << " --check\n";
+	return 1;
+}
+
+bool writeOutput(const char * output, const std::string & text)
+{
+	if(!output)
+	{
+		cout << text;
+		return true;
+	}
+	
+	std::ofstream file(output, std::ios::out | std::ios::trunc);
+	if(!file.is_open())
+	{
+		cerr << "can't write " << output << endl;
+		return false;
+	}
+	file << text;
+	return true;
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+	const char * output = nullptr;
+	const char * dump = nullptr;
+	const char * only = nullptr;
+	Baseline baseline;
+	double minSeconds = 0.5;
+	bool scaling = false;
+	bool allocations = false;
+	bool check = false;
+	double maxExponent = 1.5;
+	
+	for(int i = 1;i < argc;i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if(std::strcmp(argv[i], "-o") == 0 && hasValue)
+			output = argv[++i];
+		else if(std::strcmp(argv[i], "-t") == 0 && hasValue)
+			minSeconds = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-s") == 0 && hasValue)
+			only = argv[++i];
+		else if(std::strcmp(argv[i], "--dump") == 0 && hasValue)
+			dump = argv[++i];
+		else if(std::strcmp(argv[i], "--baseline") == 0 && hasValue)
+		{
+			if(!readBaseline(argv[++i], baseline))
+			{
+				cerr << "can't read " << argv[i] << endl;
+				return 1;
+			}
+		}
+		else if(std::strcmp(argv[i], "--scaling") == 0)
+			scaling = true;
+		else if(std::strcmp(argv[i], "--allocations") == 0)
+			allocations = true;
+		else if(std::strcmp(argv[i], "--check") == 0)
+			check = true;
+		else if(std::strcmp(argv[i], "--max-exponent") == 0 && hasValue)
+			maxExponent = std::atof(argv[++i]);
+		else
+			return usage(argv[0]);
+	}
+	
+	if(check)
+		return runChecks() > 0 ? 1 : 0;
+	
+	if(scaling)
+	{
+		std::ostringstream json;
+		int failures = runScaling(json, maxExponent);
+		if(!writeOutput(output, json.str()))
+			return 1;
+		return failures > 0 ? 1 : 0;
+	}
+	
+	if(allocations)
+	{
+		std::ostringstream json;
+		runAllocations(json, only, baseline);
+		return writeOutput(output, json.str()) ? 0 : 1;
+	}
+	
+	char tmpl[] = "/tmp/jdq-bench.XXXXXX";
+	std::string scratch = mkdtemp(tmpl) ? tmpl : ".";
+	
+	std::ostringstream json;
+	json << "{\n  \"version\": \"" JDECOMQILER_VERSION "\",\n  \"build\": \"" JDQ_BUILD "\",\n  \"min_seconds_per_stage\": " << minSeconds << ",\n  \"scenarios\": [\n";
+	bool first = true;
+	for(const Scenario & scenario : scenarios())
+	{
+		if(only && std::strcmp(only, scenario.name) != 0)
+			continue;
+		
+		std::vector<std::vector<std::uint8_t>> classes = synthesizeScenario(scenario, dump);
+		if(dump)
+			continue;
+		
+		std::uint64_t classBytes = 0;
+		for(const auto & data : classes)
+			classBytes += data.size();
+		
+		cerr << scenario.name << ": " << classes.size() << " classes, " << classBytes << " bytes" << endl;
+		
+		StageResult parse = measure(minSeconds, [&](std::uint64_t & count) {
+			for(const auto & data : classes)
+			{
+				ClassFile cf(data.data(), data.size());
+				count++;
+			}
+			return classBytes;
+		});
+		
+		std::vector<std::unique_ptr<ClassFile>> parsed;
+		for(const auto & data : classes)
+			parsed.emplace_back(new ClassFile(data.data(), data.size()));
+		
+		std::vector<std::string> texts;
+		StageResult generate = measure(minSeconds, [&](std::uint64_t & count) {
+			texts.clear();
+			for(const auto & cf : parsed)
+			{
+				std::ostringstream text;
+				cf->generate(text);
+				texts.push_back(text.str());
+				count++;
+			}
+			return classBytes;
+		});
+		
+		std::uint64_t textBytes = 0;
+		for(const std::string & text : texts)
+			textBytes += text.size();
+		
+		StageResult write = measure(minSeconds, [&](std::uint64_t & count) {
+			for(std::size_t i = 0;i < texts.size();i++)
+			{
+				writeFile(scratch + "/" + std::to_string(i) + ".java", texts[i]);
+				count++;
+			}
+			return textBytes;
+		});
+		
+		DecompileOptions decompileOptions;
+		StageResult total = measure(minSeconds, [&](std::uint64_t & count) {
+			for(const auto & data : classes)
+			{
+				StringSink sink;
+				decompile(data.data(), data.size(), decompileOptions, sink);
+				count++;
+			}
+			return classBytes;
+		});
+		
+		json << (first ? "" : ",\n") << "    {\n      \"name\": ";
+		writeJsonString(json, scenario.name);
+		json << ",\n      \"classes\": " << classes.size() << ",\n      \"class_bytes\": " << classBytes
+		     << ",\n      \"java_bytes\": " << textBytes << ",\n      \"stages\": {\n";
+		writeStage(json, scenario.name, "parse", parse, baseline, false);
+		writeStage(json, scenario.name, "generate", generate, baseline, false);
+		writeStage(json, scenario.name, "write", write, baseline, false);
+		writeStage(json, scenario.name, "decompile", total, baseline, true);
+		json << "      }\n    }";
+		first = false;
+	}
+	json << "\n  ]\n}\n";
+	
+	for(std::size_t i = 0;i < 1000000;i++)
+	{
+		if(unlink((scratch + "/" + std::to_string(i) + ".java").c_str()) != 0)
+			break;
+	}
+	rmdir(scratch.c_str());
+	
+	if(dump)
+		return 0;
+	
+	return writeOutput(output, json.str()) ? 0 : 1;
+}
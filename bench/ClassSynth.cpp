@@ -0,0 +1,454 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "ClassSynth.h"
+#include <algorithm>
+
+namespace {
+
+enum
+{
+	TAG_UTF8 = 1,
+	TAG_INTEGER = 3,
+	TAG_CLASS = 7,
+	TAG_STRING = 8,
+	TAG_METHODREF = 10,
+	TAG_NAME_AND_TYPE = 12
+};
+
+const unsigned STRINGS = 16;
+const unsigned MAX_CODE = 65535;
+
+class Writer
+{
+public:
+	void u1(unsigned value)
+	{
+		bytes.push_back(static_cast<std::uint8_t>(value));
+	}
+	
+	void u2(unsigned value)
+	{
+		u1(value >> 8);
+		u1(value);
+	}
+	
+	void u4(std::uint32_t value)
+	{
+		u2(value >> 16);
+		u2(value & 0xffff);
+	}
+	
+	void append(const Writer & other)
+	{
+		bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
+	}
+	
+	std::size_t size() const
+	{
+		return bytes.size();
+	}
+	
+	void patch2(std::size_t pos, unsigned value)
+	{
+		bytes[pos] = static_cast<std::uint8_t>(value >> 8);
+		bytes[pos + 1] = static_cast<std::uint8_t>(value);
+	}
+	
+	void patch4(std::size_t pos, std::uint32_t value)
+	{
+		patch2(pos, value >> 16);
+		patch2(pos + 2, value & 0xffff);
+	}
+	
+	std::vector<std::uint8_t> bytes;
+};
+
+class ConstantPoolWriter
+{
+public:
+	unsigned utf8(const std::string & str)
+	{
+		pool.u1(TAG_UTF8);
+		pool.u2(static_cast<unsigned>(str.size()));
+		for(char c : str)
+			pool.u1(static_cast<unsigned char>(c));
+		return next++;
+	}
+	
+	unsigned classInfo(const std::string & name)
+	{
+		unsigned index = utf8(name);
+		pool.u1(TAG_CLASS);
+		pool.u2(index);
+		return next++;
+	}
+	
+	unsigned string(const std::string & str)
+	{
+		unsigned index = utf8(str);
+		pool.u1(TAG_STRING);
+		pool.u2(index);
+		return next++;
+	}
+	
+	unsigned integer(std::uint32_t value)
+	{
+		pool.u1(TAG_INTEGER);
+		pool.u4(value);
+		return next++;
+	}
+	
+	unsigned methodref(unsigned classIndex, unsigned name, unsigned descriptor)
+	{
+		pool.u1(TAG_NAME_AND_TYPE);
+		pool.u2(name);
+		pool.u2(descriptor);
+		unsigned nameAndType = next++;
+		pool.u1(TAG_METHODREF);
+		pool.u2(classIndex);
+		pool.u2(nameAndType);
+		return next++;
+	}
+	
+	Writer pool;
+	unsigned next = 1; // count once written
+};
+
+// xorshift, the output only depends on the seed
+class Random
+{
+public:
+	Random(unsigned seed)
+		: state(seed * 2654435761u + 1)
+	{
+	}
+	
+	unsigned next(unsigned bound)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return bound ? state % bound : 0;
+	}
+
+private:
+	std::uint32_t state;
+};
+
+struct Constants
+{
+	unsigned strings[STRINGS];
+	unsigned sink;
+	unsigned builder; // java/lang/StringBuilder
+	unsigned builderInit;
+	unsigned append;
+	unsigned toString;
+	unsigned object; // java/lang/Object, only with newObjects
+	unsigned objectInit;
+};
+
+// static int m(int i0, int i1), i2 being the only other local
+class MethodWriter
+{
+public:
+	MethodWriter(const SynthOptions & options, const Constants & constants, Random & random)
+		: options(options), constants(constants), random(random)
+	{
+	}
+	
+	Writer code(unsigned index)
+	{
+		unsigned length = std::min(options.methodLength, MAX_CODE - 64);
+		
+		// i2 = i0 + i1;
+		out.u1(0x1a); // iload_0
+		out.u1(0x1b); // iload_1
+		out.u1(0x60); // iadd
+		out.u1(0x3d); // istore_2
+		
+		if(options.appendChain > 0)
+			appendChain();
+		for(unsigned i = 0;i < options.newObjects && out.size() < length;i++)
+			newObject();
+		
+		bool hasSwitch = options.switchCases > 0;
+		while(out.size() < length)
+		{
+			if(hasSwitch && out.size() >= length / 2)
+			{
+				if(!switchStatement(index % 2 == 0))
+					break;
+				hasSwitch = false;
+			}
+			else if(random.next(100) < options.branchPercent && options.nesting > 0)
+			{
+				ifStatement(options.nesting);
+			}
+			else
+			{
+				statement();
+			}
+		}
+		
+		out.u1(0x1c); // iload_2
+		out.u1(0xac); // ireturn
+		return out;
+	}
+
+private:
+	void statement()
+	{
+		switch(random.next(4))
+		{
+			case 0: // i2 = i2 * k;
+				out.u1(0x1c); // iload_2
+				out.u1(0x10); // bipush
+				out.u1(2 + random.next(90));
+				out.u1(0x68); // imul
+				out.u1(0x3d); // istore_2
+				break;
+			case 1: // i2 += k;
+				out.u1(0x84); // iinc
+				out.u1(2);
+				out.u1(1 + random.next(90));
+				break;
+			case 2: // sink(i2, "...");
+				out.u1(0x1c); // iload_2
+				out.u1(0x12); // ldc
+				out.u1(constants.strings[random.next(STRINGS)]);
+				out.u1(0xb8); // invokestatic
+				out.u2(constants.sink);
+				break;
+			default: // i2 = i0 + i2;
+				out.u1(0x1a); // iload_0
+				out.u1(0x1c); // iload_2
+				out.u1(0x60); // iadd
+				out.u1(0x3d); // istore_2
+				break;
+		}
+	}
+	
+	// sink(i2, new StringBuilder().append("...")...toString());
+	void appendChain()
+	{
+		unsigned calls = std::min(options.appendChain, (MAX_CODE - 64) / 5);
+		out.u1(0x1c); // iload_2
+		out.u1(0xbb); // new
+		out.u2(constants.builder);
+		out.u1(0x59); // dup
+		out.u1(0xb7); // invokespecial
+		out.u2(constants.builderInit);
+		for(unsigned i = 0;i < calls;i++)
+		{
+			out.u1(0x12); // ldc
+			out.u1(constants.strings[random.next(STRINGS)]);
+			out.u1(0xb6); // invokevirtual
+			out.u2(constants.append);
+		}
+		out.u1(0xb6);
+		out.u2(constants.toString);
+		out.u1(0xb8); // invokestatic
+		out.u2(constants.sink);
+	}
+	
+	// new Object();
+	void newObject()
+	{
+		out.u1(0xbb); // new
+		out.u2(constants.object);
+		out.u1(0x59); // dup
+		out.u1(0xb7); // invokespecial
+		out.u2(constants.objectInit);
+		out.u1(0x57); // pop
+	}
+	
+	// if(i0 != 0) { [nested if] statement }
+	void ifStatement(unsigned depth)
+	{
+		std::size_t start = out.size();
+		out.u1(0x1a); // iload_0
+		out.u1(0x99 + random.next(3)); // ifeq, ifne, iflt
+		out.u2(0);
+		
+		if(depth > 1)
+			ifStatement(depth - 1);
+		statement();
+		
+		out.patch2(start + 2, static_cast<unsigned>(out.size() - start - 1));
+	}
+	
+	// every case is i2 += k; and jumps to the end of the switch, or, when
+	// that doesn't fit in the method, all of them go to the end directly
+	bool switchStatement(bool table)
+	{
+		unsigned cases = options.switchCases;
+		std::size_t needed = out.size() + 1 + 3 + 12 + cases * (table ? 4 : 8);
+		bool bodies = options.caseBodies && needed + cases * (3 + 3) <= MAX_CODE - 8; // iinc, goto
+		if(needed > MAX_CODE - 8)
+			return false;
+		
+		out.u1(0x1a); // iload_0
+		std::size_t start = out.size();
+		out.u1(table ? 0xaa : 0xab);
+		while(out.size() % 4)
+			out.u1(0);
+		
+		std::size_t defaultPos = out.size();
+		out.u4(0);
+		if(table)
+		{
+			out.u4(0);
+			out.u4(cases - 1);
+		}
+		else
+		{
+			out.u4(cases);
+		}
+		
+		std::size_t tablePos = out.size();
+		for(unsigned i = 0;i < cases;i++)
+		{
+			if(!table)
+				out.u4(i * 3); // sorted keys
+			out.u4(0);
+		}
+		
+		std::vector<std::size_t> gotos;
+		for(unsigned i = 0;i < cases && bodies;i++)
+		{
+			std::size_t offset = out.size() - start;
+			out.patch4(table ? tablePos + 4 * i : tablePos + 8 * i + 4, static_cast<std::uint32_t>(offset));
+			out.u1(0x84); // iinc
+			out.u1(2);
+			out.u1(1 + random.next(90));
+			gotos.push_back(out.size());
+			out.u1(0xa7); // goto
+			out.u2(0);
+		}
+		
+		std::size_t endOffset = out.size() - start;
+		out.patch4(defaultPos, static_cast<std::uint32_t>(endOffset));
+		for(unsigned i = 0;i < cases && !bodies;i++)
+			out.patch4(table ? tablePos + 4 * i : tablePos + 8 * i + 4, static_cast<std::uint32_t>(endOffset));
+		for(std::size_t pos : gotos)
+			out.patch2(pos + 1, static_cast<unsigned>(out.size() - pos));
+		return true;
+	}
+	
+	const SynthOptions & options;
+	const Constants & constants;
+	Random & random;
+	Writer out;
+};
+
+}
+
+std::vector<std::uint8_t> synthesizeClass(const std::string & name, const SynthOptions & options)
+{
+	Random random(options.seed);
+	ConstantPoolWriter cp;
+	
+	unsigned thisClass = cp.classInfo(name);
+	unsigned superClass = cp.classInfo("java/lang/Object");
+	unsigned codeName = cp.utf8("Code");
+	unsigned descriptor = cp.utf8("(II)I");
+	unsigned sinkName = cp.utf8("sink");
+	unsigned sinkDescriptor = cp.utf8("(ILjava/lang/String;)V");
+	
+	Constants constants;
+	constants.sink = cp.methodref(thisClass, sinkName, sinkDescriptor);
+	for(unsigned i = 0;i < STRINGS;i++)
+		constants.strings[i] = cp.string("string " + std::to_string(i)); // below 256, for ldc
+	
+	constants.builder = cp.classInfo("java/lang/StringBuilder");
+	constants.builderInit = cp.methodref(constants.builder, cp.utf8("<init>"), cp.utf8("()V"));
+	constants.append = cp.methodref(constants.builder, cp.utf8("append"), cp.utf8("(Ljava/lang/String;)Ljava/lang/StringBuilder;"));
+	constants.toString = cp.methodref(constants.builder, cp.utf8("toString"), cp.utf8("()Ljava/lang/String;"));
+	if(options.newObjects > 0)
+	{
+		// the pool of the other classes stays the same
+		constants.object = superClass;
+		constants.objectInit = cp.methodref(superClass, cp.utf8("<init>"), cp.utf8("()V"));
+	}
+	
+	std::vector<unsigned> methodNames;
+	for(unsigned i = 0;i < options.methods;i++)
+		methodNames.push_back(cp.utf8("m" + std::to_string(i)));
+	
+	while(cp.next < options.constants && cp.next < 65535)
+		cp.integer(random.next(0xffffffffu));
+	
+	Writer methods;
+	for(unsigned i = 0;i < options.methods;i++)
+	{
+		MethodWriter method(options, constants, random);
+		Writer code = method.code(i);
+		
+		methods.u2(0x0009); // public static
+		methods.u2(methodNames[i]);
+		methods.u2(descriptor);
+		methods.u2(1); // attributes
+		methods.u2(codeName);
+		methods.u4(static_cast<std::uint32_t>(12 + code.size()));
+		methods.u2(4); // max stack
+		methods.u2(3); // max locals
+		methods.u4(static_cast<std::uint32_t>(code.size()));
+		methods.append(code);
+		methods.u2(0); // exception table
+		methods.u2(0); // attributes
+	}
+	
+	// static void sink(int, String) { }
+	methods.u2(0x0009);
+	methods.u2(sinkName);
+	methods.u2(sinkDescriptor);
+	methods.u2(1);
+	methods.u2(codeName);
+	methods.u4(13);
+	methods.u2(0);
+	methods.u2(2);
+	methods.u4(1);
+	methods.u1(0xb1); // return
+	methods.u2(0);
+	methods.u2(0);
+	
+	Writer file;
+	file.u4(0xcafebabe);
+	file.u2(0); // minor
+	// Java 5: the methods branch but have no StackMapTable, which class
+	// files are expected to carry from major version 50 on
+	file.u2(49);
+	file.u2(cp.next);
+	file.append(cp.pool);
+	file.u2(0x0021); // public super
+	file.u2(thisClass);
+	file.u2(superClass);
+	file.u2(0); // interfaces
+	file.u2(0); // fields
+	file.u2(options.methods + 1);
+	file.append(methods);
+	file.u2(0); // attributes
+	return file.bytes;
+}
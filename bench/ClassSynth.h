@@ -0,0 +1,53 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef CLASSSYNTH_H
+#define CLASSSYNTH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// writes valid class files without a JDK, built only from the constructs
+// the decompiler understands: int arithmetic, ldc of strings, static calls,
+// forward ifs, iinc, table and lookup switches, StringBuilder chains,
+// objects created and dropped
+
+struct SynthOptions
+{
+	unsigned constants = 0; // minimum size of the constant pool, padded with Integer constants
+	unsigned methods = 4;
+	unsigned methodLength = 256; // bytes of bytecode per method, roughly (at most 65535)
+	unsigned branchPercent = 10; // statements wrapped in ifs, in percent
+	unsigned nesting = 1; // depth of these ifs
+	unsigned switchCases = 0; // cases of the switch in each method, none if 0
+	bool caseBodies = true; // each case has its own statement, when they fit in the method
+	unsigned appendChain = 0; // calls in a new StringBuilder().append(...)... chain at the start of each method
+	unsigned newObjects = 0; // new Object(); statements at the start of each method
+	unsigned seed = 1;
+};
+
+std::vector<std::uint8_t> synthesizeClass(const std::string & name, const SynthOptions & options);
+
+#endif
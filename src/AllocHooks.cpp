@@ -0,0 +1,53 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Stats.h"
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// counts the allocations of the class being decompiled by the calling thread
+// only linked into the command line tool, the library leaves operator new alone
+// the sizes are the ones of the malloc() blocks, so that new and delete agree
+
+#ifndef JDQ_NO_STATS
+
+void * operator new(std::size_t size)
+{
+	void * p = std::malloc(size ? size : 1);
+	if(!p)
+		throw std::bad_alloc();
+	if(currentClassStats)
+		countAllocation(malloc_usable_size(p));
+	return p;
+}
+
+void operator delete(void * p) noexcept
+{
+	if(p && currentClassStats)
+		countFree(malloc_usable_size(p));
+	std::free(p);
+}
+
+#endif
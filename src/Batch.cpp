@@ -0,0 +1,538 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Batch.h"
+#include "BoundedQueue.h"
+#include "Cache.h"
+#include "ClassFile.h"
+#include "Diagnostics.h"
+#include "FileUtils.h"
+#include "Hash.h"
+#include "JarReader.h"
+#include "Json.h"
+#include "Stats.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+struct ClassTask
+{
+	std::uint64_t sequence = 0; // position in the input
+	std::string name; // internal name, from the path of the class in its input
+	std::vector<std::uint8_t> bytes;
+	std::unique_ptr<ClassFile> classFile;
+	std::string cacheKey;
+	std::string text;
+	std::string inputHash;
+	const char * status = "ok";
+	std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+	ClassStats stats;
+	
+	ClassStats * statsIfEnabled()
+	{
+		return statsEnabled() ? &stats : nullptr;
+	}
+};
+
+typedef std::unique_ptr<ClassTask> TaskPtr;
+typedef BoundedQueue<TaskPtr> TaskQueue;
+
+std::string classNameFromPath(const std::string & path)
+{
+	return path.substr(0, path.size() - 6); // ".class"
+}
+
+std::string baseName(const std::string & path)
+{
+	std::size_t pos = path.rfind('/');
+	return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+// with a text, the record is the one of --ndjson
+void writeManifestRecord(std::ostream & manifest, const std::string & name, const std::string & hash, const std::string & output, const std::string & status, long long timeUs, const ClassStats * stats, const std::string * text = nullptr)
+{
+	manifest << "{\"class\":";
+	writeJsonString(manifest, name);
+	manifest << ",\"input_hash\":\"" << hash << "\",\"output\":";
+	writeJsonString(manifest, output);
+	manifest << ",\"status\":\"" << status << "\",\"time_us\":" << timeUs;
+	if(stats)
+	{
+		// flat, so that mergeShards() can still read the record
+		for(int i = 0;i < STAGE_COUNT;i++)
+			manifest << ",\"" << stageName(i) << "_us\":" << stats->stageNanos[i] / 1000;
+		
+		if(stats->counters[COUNTER_ALLOCATIONS] > 0)
+		{
+			manifest << ",\"allocations\":" << stats->counters[COUNTER_ALLOCATIONS]
+			         << ",\"allocated_bytes\":" << stats->counters[COUNTER_ALLOCATED_BYTES]
+			         << ",\"peak_bytes\":" << stats->peakBytes;
+			for(int i = 0;i < STAGE_COUNT;i++)
+				manifest << ",\"" << stageName(i) << "_peak_bytes\":" << stats->stagePeakBytes[i];
+		}
+	}
+	if(text)
+	{
+		manifest << ",\"text\":";
+		writeJsonString(manifest, *text);
+	}
+	manifest << "}\n";
+}
+
+class Pipeline
+{
+public:
+	Pipeline(const BatchOptions & options)
+		: options(options),
+		  parseQueue(options.queueDepth, 1),
+		  decompileQueue(options.queueDepth, options.jobs),
+		  writeQueue(options.queueDepth, options.jobs),
+		  failed(0)
+	{
+	}
+	
+	BatchResult run()
+	{
+		std::vector<std::thread> threads;
+		threads.emplace_back(&Pipeline::read, this);
+		for(int i = 0;i < options.jobs;i++)
+		{
+			threads.emplace_back(&Pipeline::parse, this, i);
+			threads.emplace_back(&Pipeline::decompile, this, i);
+		}
+		
+		write();
+		
+		for(auto & thread : threads)
+			thread.join();
+		
+		result.failed += failed;
+		return result;
+	}
+
+private:
+	bool inShard(const std::string & name)
+	{
+		return shardOf(name, options.shardCount) == options.shardIndex;
+	}
+	
+	TaskPtr newTask(const std::string & name)
+	{
+		if(options.ordered)
+		{
+			// the writer holds the classes which finish before the next one
+			// in order: keep their number bounded
+			std::unique_lock<std::mutex> lock(windowMutex);
+			windowFree.wait(lock, [this] { return sequence - written < options.reorderWindow; });
+		}
+		
+		TaskPtr task(new ClassTask);
+		task->sequence = sequence++;
+		task->name = name;
+		return task;
+	}
+	
+	void readJar(const std::string & path)
+	{
+		JarReader jar(path);
+		if(!jar.isOpen())
+		{
+			DIAG(DIAG_ERROR, "can't open " << path << " as a jar");
+			failed++;
+			return;
+		}
+		
+		JarReader::Entry entry;
+		while(jar.nextEntry(entry))
+		{
+			if(!endsWith(entry.name, ".class") || !inShard(classNameFromPath(entry.name)))
+				continue;
+			
+			TaskPtr task = newTask(classNameFromPath(entry.name));
+			// the name becomes the output path, it must stay under the output directory
+			if(!isSafeRelativePath(entry.name))
+			{
+				DIAG(DIAG_ERROR, "entry " << entry.name << " of " << path << " has an unsafe name, skipped");
+				task->status = "invalid_path";
+				parseQueue.push(std::move(task));
+				continue;
+			}
+			{
+				TRACE_SCOPE("read", task->name);
+				STATS_SCOPE(task->statsIfEnabled());
+				STATS_TIMER(STAGE_READ);
+				if(!jar.read(entry, task->bytes))
+				{
+					DIAG(DIAG_ERROR, "can't inflate " << entry.name << " from " << path);
+					task->status = "read_error";
+				}
+			}
+			parseQueue.push(std::move(task));
+		}
+	}
+	
+	void readClass(const std::string & path, const std::string & name)
+	{
+		if(!inShard(name))
+			return;
+		
+		TaskPtr task = newTask(name);
+		{
+			TRACE_SCOPE("read", task->name);
+			STATS_SCOPE(task->statsIfEnabled());
+			STATS_TIMER(STAGE_READ);
+			if(!readFile(path, task->bytes))
+			{
+				DIAG(DIAG_ERROR, "can't read " << path);
+				task->status = "read_error";
+			}
+		}
+		parseQueue.push(std::move(task));
+	}
+	
+	void read()
+	{
+		setTraceThreadName("read");
+		for(const std::string & input : options.inputs)
+		{
+			if(isDirectory(input))
+			{
+				for(const std::string & file : listFiles(input))
+				{
+					if(endsWith(file, ".class"))
+						readClass(input + "/" + file, classNameFromPath(file));
+					else if(endsWith(file, ".jar"))
+						readJar(input + "/" + file);
+				}
+			}
+			else if(endsWith(input, ".jar"))
+			{
+				readJar(input);
+			}
+			else
+			{
+				std::string name = baseName(input);
+				if(endsWith(name, ".class"))
+					name = classNameFromPath(name);
+				readClass(input, name);
+			}
+		}
+		parseQueue.done();
+	}
+	
+	void parseTask(ClassTask & task)
+	{
+		TRACE_SCOPE("parse", task.name);
+		STATS_SCOPE(task.statsIfEnabled());
+		DIAG_CONTEXT(&task.name);
+		const DecompileOptions & decompileOptions = options.decompile;
+		auto start = std::chrono::steady_clock::now();
+		task.inputHash = toHex(xxhash64(task.bytes.data(), task.bytes.size()));
+		
+		DecompileCache * cache = decompileOptions.cache;
+		bool cached = false;
+		if(cache && cache->isOpen())
+		{
+			task.cacheKey = cacheKey(task.bytes.data(), task.bytes.size(), decompileOptions);
+			cached = cache->lookup(task.cacheKey, task.text);
+			if(cached)
+				task.cacheKey.clear(); // nothing to store
+		}
+		
+		if(!cached)
+		{
+			task.classFile.reset(new ClassFile(task.bytes.data(), task.bytes.size()));
+			if(!task.classFile->isValid())
+			{
+				task.status = "invalid_class";
+				task.classFile.reset();
+			}
+		}
+		// the parsed class points into the bytes, they go with it
+		if(!task.classFile)
+			std::vector<std::uint8_t>().swap(task.bytes);
+		task.time += std::chrono::steady_clock::now() - start;
+	}
+	
+	void parse(int worker)
+	{
+		setTraceThreadName("parse " + std::to_string(worker));
+		TaskPtr task;
+		while(parseQueue.pop(task))
+		{
+			if(std::strcmp(task->status, "ok") == 0)
+				parseTask(*task);
+			
+			decompileQueue.push(std::move(task));
+		}
+		decompileQueue.done();
+	}
+	
+	void decompile(int worker)
+	{
+		setTraceThreadName("decompile " + std::to_string(worker));
+		TaskPtr task;
+		while(decompileQueue.pop(task))
+		{
+			if(task->classFile)
+			{
+				TRACE_SCOPE("decompile", task->name);
+				STATS_SCOPE(task->statsIfEnabled());
+				auto start = std::chrono::steady_clock::now();
+				StringSink output;
+				if(writeClass(*task->classFile, options.decompile, output) > 0)
+					task->status = "partial";
+				task->classFile.reset();
+				std::vector<std::uint8_t>().swap(task->bytes);
+				task->text = std::move(output.text);
+				
+				if(!task->cacheKey.empty() && std::strcmp(task->status, "ok") == 0)
+					options.decompile.cache->store(task->cacheKey, task->text);
+				task->time += std::chrono::steady_clock::now() - start;
+			}
+			
+			writeQueue.push(std::move(task));
+		}
+		writeQueue.done();
+	}
+	
+	void write()
+	{
+		setTraceThreadName("write");
+		std::ofstream manifest;
+		if(!options.manifest.empty() && makeDirectories(options.outputDirectory))
+		{
+			manifest.open(options.manifest, std::ios::out | std::ios::trunc);
+			if(!manifest.is_open())
+				DIAG(DIAG_ERROR, "can't write " << options.manifest);
+		}
+		
+		TaskPtr task;
+		std::map<std::uint64_t, TaskPtr> early; // finished before their turn, when ordered
+		while(writeQueue.pop(task))
+		{
+			if(!options.ordered)
+			{
+				writeTask(*task, manifest);
+				continue;
+			}
+			
+			early[task->sequence] = std::move(task);
+			for(auto next = early.begin();next != early.end() && next->first == written;next = early.erase(next))
+			{
+				writeTask(*next->second, manifest);
+				{
+					std::lock_guard<std::mutex> lock(windowMutex);
+					written++;
+				}
+				windowFree.notify_one();
+			}
+		}
+	}
+	
+	void writeTask(ClassTask & task, std::ofstream & manifest)
+	{
+		auto start = std::chrono::steady_clock::now();
+		std::string output = task.name + outputExtension(options.decompile.format);
+		
+		result.classes++;
+		if(std::strcmp(task.status, "ok") == 0 && !isSafeRelativePath(output))
+		{
+			DIAG(DIAG_ERROR, "class " << task.name << " would be written outside " << options.outputDirectory << ", skipped");
+			task.status = "invalid_path";
+		}
+		
+		if(std::strcmp(task.status, "invalid_class") == 0)
+		{
+			DIAG(DIAG_ERROR, task.name << " is not a valid class file");
+		}
+		else if((std::strcmp(task.status, "ok") == 0 || std::strcmp(task.status, "partial") == 0) && !options.ndjson)
+		{
+			TRACE_SCOPE("write", task.name);
+			STATS_SCOPE(task.statsIfEnabled());
+			STATS_TIMER(STAGE_WRITE);
+			std::string path = options.outputDirectory + "/" + output;
+			std::size_t slash = path.rfind('/');
+			if(!makeDirectories(path.substr(0, slash)) || !writeFile(path, task.text))
+			{
+				DIAG(DIAG_ERROR, "can't write " << path);
+				task.status = "write_error";
+			}
+		}
+		
+		if(std::strcmp(task.status, "partial") == 0)
+		{
+			result.partial++;
+		}
+		else if(std::strcmp(task.status, "ok") != 0)
+		{
+			result.failed++;
+			output.clear();
+		}
+		
+		task.time += std::chrono::steady_clock::now() - start;
+		long long timeUs = std::chrono::duration_cast<std::chrono::microseconds>(task.time).count();
+		if(manifest.is_open())
+			writeManifestRecord(manifest, task.name, task.inputHash, output, task.status, timeUs, task.statsIfEnabled());
+		if(options.ndjson)
+		{
+			TRACE_SCOPE("write", task.name);
+			STATS_SCOPE(task.statsIfEnabled());
+			STATS_TIMER(STAGE_WRITE);
+			// flushed right away, the reader of the pipe may be waiting for this class
+			writeManifestRecord(cout, task.name, task.inputHash, output, task.status, timeUs, task.statsIfEnabled(), output.empty() ? nullptr : &task.text);
+			cout.flush();
+		}
+		if(statsEnabled())
+			addClassStats(task.stats, task.name);
+	}
+	
+	const BatchOptions & options;
+	TaskQueue parseQueue;
+	TaskQueue decompileQueue;
+	TaskQueue writeQueue;
+	std::atomic<std::uint64_t> failed; // before the write stage
+	BatchResult result;
+	// when ordered, the reader waits for the writer to be less than
+	// reorderWindow classes behind
+	std::mutex windowMutex;
+	std::condition_variable windowFree;
+	std::uint64_t sequence = 0; // of the next class read
+	std::uint64_t written = 0;
+};
+
+}
+
+BatchResult runBatch(const BatchOptions & options)
+{
+	BatchOptions checked = options;
+	if(checked.jobs < 1)
+		checked.jobs = 1;
+	if(checked.queueDepth < 1)
+		checked.queueDepth = 1;
+	if(checked.reorderWindow < 1)
+		checked.reorderWindow = 1;
+	
+	Pipeline pipeline(checked);
+	return pipeline.run();
+}
+
+int shardOf(const std::string & className, int shardCount)
+{
+	if(shardCount <= 1)
+		return 0;
+	
+	return static_cast<int>(xxhash64(className.data(), className.size()) % static_cast<std::uint64_t>(shardCount));
+}
+
+BatchResult mergeShards(const std::string & outputDirectory, const std::vector<std::string> & shardDirectories)
+{
+	BatchResult result;
+	std::map<std::string, std::string> records; // class name -> manifest line, sorted
+	
+	for(const std::string & shard : shardDirectories)
+	{
+		std::ifstream manifest(shard + "/manifest.jsonl");
+		if(!manifest.is_open())
+		{
+			DIAG(DIAG_ERROR, "no manifest in " << shard);
+			result.failed++;
+			continue;
+		}
+		
+		std::string line;
+		while(std::getline(manifest, line))
+		{
+			std::map<std::string, std::string> fields;
+			if(!parseJsonObject(line, fields))
+			{
+				DIAG(DIAG_ERROR, "invalid manifest record in " << shard << ": " << line);
+				result.failed++;
+				continue;
+			}
+			
+			const std::string & name = fields["class"];
+			if(records.count(name))
+			{
+				DIAG(DIAG_WARNING, name << " is in more than one shard, keeping the first one");
+				continue;
+			}
+			
+			result.classes++;
+			const std::string & output = fields["output"];
+			if(fields["status"] == "ok" || fields["status"] == "partial")
+			{
+				// read in the shard and written in the merged directory
+				if(!isSafeRelativePath(output))
+				{
+					DIAG(DIAG_ERROR, "record of " << name << " in " << shard << " has an unsafe output path " << output << ", skipped");
+					result.failed++;
+					continue;
+				}
+				
+				std::vector<std::uint8_t> data;
+				std::string path = outputDirectory + "/" + output;
+				if(!readFile(shard + "/" + output, data)
+					|| !makeDirectories(path.substr(0, path.rfind('/')))
+					|| !writeFile(path, std::string(data.begin(), data.end())))
+				{
+					DIAG(DIAG_ERROR, "can't copy " << output << " from " << shard);
+					result.failed++;
+					continue;
+				}
+			}
+			else
+			{
+				result.failed++;
+			}
+			records[name] = line;
+		}
+	}
+	
+	if(!makeDirectories(outputDirectory))
+	{
+		DIAG(DIAG_ERROR, "can't create " << outputDirectory);
+		result.failed++;
+		return result;
+	}
+	
+	std::ofstream merged(outputDirectory + "/manifest.jsonl", std::ios::out | std::ios::trunc);
+	for(const auto & record : records)
+		merged << record.second << "\n";
+	
+	return result;
+}
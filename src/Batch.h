@@ -0,0 +1,69 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "JDecomqiler.h"
+
+struct BatchOptions
+{
+	std::vector<std::string> inputs; // class files, jars or directories
+	std::string outputDirectory;
+	DecompileOptions decompile;
+	int jobs = 1; // threads for each of the parse and decompile stages
+	std::size_t queueDepth = 16; // classes waiting between two stages
+	int shardIndex = 0; // only decompile the classes of this shard
+	int shardCount = 1;
+	std::string manifest; // one JSON record per class, none if empty
+	bool ndjson = false; // the records, with the output text, on stdout instead of files
+	bool ordered = false; // records and files in input order rather than as the classes finish
+	std::size_t reorderWindow = 256; // when ordered, most classes read past the next one to write
+};
+
+struct BatchResult
+{
+	std::uint64_t classes = 0;
+	std::uint64_t failed = 0;
+	std::uint64_t partial = 0; // written, with some methods replaced by stubs
+};
+
+// read -> parse -> decompile -> write, each stage in its own thread(s) and
+// connected to the next by a bounded queue: at most a few queueDepth classes
+// are in memory at any time, whatever the size of the input
+BatchResult runBatch(const BatchOptions & options);
+
+// stable across runs and hosts, the name being the internal name of the class
+int shardOf(const std::string & className, int shardCount);
+
+// copies the output of each shard, listed in its manifest.jsonl, into
+// outputDirectory and writes the combined manifest.jsonl there
+BatchResult mergeShards(const std::string & outputDirectory, const std::vector<std::string> & shardDirectories);
+
+#endif
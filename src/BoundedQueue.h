@@ -0,0 +1,83 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// FIFO between two pipeline stages: push() blocks while the queue is full,
+// which is what keeps a fast producer from piling up work in memory
+// the queue closes itself once every producer has called done()
+template<typename T>
+class BoundedQueue
+{
+public:
+	BoundedQueue(std::size_t capacity, int producers = 1)
+		: capacity(capacity), producers(producers)
+	{
+	}
+	
+	void push(T && item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this] { return items.size() < capacity; });
+		items.push_back(std::move(item));
+		notEmpty.notify_one();
+	}
+	
+	// returns false once the queue is closed and drained
+	bool pop(T & item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this] { return !items.empty() || producers == 0; });
+		if(items.empty())
+			return false;
+		
+		item = std::move(items.front());
+		items.pop_front();
+		notFull.notify_one();
+		return true;
+	}
+	
+	void done()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(--producers == 0)
+			notEmpty.notify_all();
+	}
+
+private:
+	std::deque<T> items;
+	std::size_t capacity;
+	int producers;
+	std::mutex mutex;
+	std::condition_variable notFull;
+	std::condition_variable notEmpty;
+};
+
+#endif
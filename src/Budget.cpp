@@ -0,0 +1,63 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Budget.h"
+
+// instructions between two reads of the clock
+static const std::uint64_t CLOCK_CHECK_INTERVAL = 256;
+
+bool Budget::isSet() const
+{
+	return instructions || milliseconds || bytes;
+}
+
+BudgetMeter::BudgetMeter(const Budget & budget)
+	: budget(budget), start(std::chrono::steady_clock::now())
+{
+}
+
+const char * BudgetMeter::spend(std::uint64_t spentInstructions, std::uint64_t spentBytes)
+{
+	if(reason)
+		return reason;
+	
+	instructions += spentInstructions;
+	bytes += spentBytes;
+	if(budget.instructions && instructions > budget.instructions)
+		reason = "instructions";
+	else if(budget.bytes && bytes > budget.bytes)
+		reason = "bytes";
+	else if(budget.milliseconds && instructions >= nextClockCheck)
+	{
+		nextClockCheck = instructions + CLOCK_CHECK_INTERVAL;
+		if(std::chrono::steady_clock::now() - start > std::chrono::milliseconds(budget.milliseconds))
+			reason = "time";
+	}
+	return reason;
+}
+
+const char * BudgetMeter::exceeded() const
+{
+	return reason;
+}
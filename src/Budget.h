@@ -0,0 +1,62 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <chrono>
+#include <cstdint>
+
+// limits on the work spent on a method or a class, 0 meaning no limit
+struct Budget
+{
+	std::uint64_t instructions = 0;
+	std::uint64_t milliseconds = 0;
+	std::uint64_t bytes = 0; // text of the statements and of the expressions combined by the method(s)
+	
+	bool isSet() const;
+};
+
+// what a method or a class has spent of its budget
+class BudgetMeter
+{
+public:
+	BudgetMeter(const Budget & budget);
+	
+	// adds to what was spent; returns what ran out ("instructions", "time"
+	// or "bytes"), nullptr if nothing did; cheap enough to be called for
+	// every instruction, the clock is only read every so many
+	const char * spend(std::uint64_t instructions, std::uint64_t bytes);
+	const char * exceeded() const;
+
+private:
+	Budget budget;
+	std::uint64_t instructions = 0;
+	std::uint64_t bytes = 0;
+	std::chrono::steady_clock::time_point start;
+	std::uint64_t nextClockCheck = 0; // in instructions
+	const char * reason = nullptr;
+};
+
+#endif
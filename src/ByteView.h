@@ -0,0 +1,81 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef BYTEVIEW_H
+#define BYTEVIEW_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+// a range of bytes owned by somebody else, usually the class file buffer
+class ByteView
+{
+public:
+	ByteView()
+		: bytes(nullptr), length(0)
+	{
+	}
+	
+	ByteView(const char * data, std::size_t size)
+		: bytes(data), length(size)
+	{
+	}
+	
+	const char * data() const
+	{
+		return bytes;
+	}
+	
+	std::size_t size() const
+	{
+		return length;
+	}
+	
+	bool empty() const
+	{
+		return length == 0;
+	}
+	
+	char operator[](std::size_t i) const
+	{
+		return bytes[i];
+	}
+	
+	std::string str() const
+	{
+		return std::string(bytes, length);
+	}
+
+private:
+	const char * bytes;
+	std::size_t length;
+};
+
+inline std::ostream & operator<<(std::ostream & stream, const ByteView & view)
+{
+	return stream.write(view.data(), view.size());
+}
+
+#endif
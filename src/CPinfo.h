@@ -25,7 +25,11 @@ freely, subject to the following restrictions:
 #ifndef CPINFO_H
 #define CPINFO_H
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
+
+#include "ModifiedUtf8.h"
 
 enum {
 	CONSTANT_Utf8 = 1,
@@ -44,8 +48,8 @@ enum {
 	CONSTANT_InvokeDynamic = 18
 };
 
+// the payload of a constant, 8 bytes; the tag is kept apart, see ConstantPool
 struct CPinfo {
-	std::uint8_t tag;
 	union {
 		struct {
 			std::uint16_t name_index;
@@ -74,8 +78,8 @@ struct CPinfo {
 			std::uint16_t descriptor_index;
 		} NameAndTypeInfo;
 		struct {
-			std::uint16_t length;
-			char * bytes; // (1) find a better way
+			std::uint32_t offset; // in the arena of the pool
+			std::uint32_t length; // decoded, may be longer than in the class file
 		} UTF8Info;
 		struct {
 			std::uint8_t reference_kind;
@@ -91,4 +95,67 @@ struct CPinfo {
 	};
 };
 
+// the tags and the payloads in two arrays, indexed like the class file
+// (entry 0 and the second half of Long and Double have tag 0); the text of
+// the Utf8 constants is in one arena, each nul terminated
+class ConstantPool
+{
+public:
+	void reserve(std::size_t count)
+	{
+		tags.reserve(count);
+		entries.reserve(count);
+	}
+	
+	void add(std::uint8_t tag, const CPinfo & info)
+	{
+		tags.push_back(tag);
+		entries.push_back(info);
+	}
+	
+	// bytes is the modified UTF-8 of the class file; returns false if it is
+	// malformed, the bad sequences are then stored as U+FFFD
+	bool addUtf8(const char * bytes, std::size_t length)
+	{
+		CPinfo info = CPinfo();
+		info.UTF8Info.offset = static_cast<std::uint32_t>(arena.size());
+		bool valid = decodeModifiedUtf8(bytes, length, arena);
+		info.UTF8Info.length = static_cast<std::uint32_t>(arena.size() - info.UTF8Info.offset);
+		arena.push_back('\0');
+		add(CONSTANT_Utf8, info);
+		return valid;
+	}
+	
+	std::size_t size() const
+	{
+		return tags.size();
+	}
+	
+	std::uint8_t tag(std::size_t index) const
+	{
+		return tags[index];
+	}
+	
+	const CPinfo & operator[](std::size_t index) const
+	{
+		return entries[index];
+	}
+	
+	// only for a Utf8 constant
+	const char * utf8(std::size_t index) const
+	{
+		return arena.data() + entries[index].UTF8Info.offset;
+	}
+	
+	std::size_t utf8Length(std::size_t index) const
+	{
+		return entries[index].UTF8Info.length;
+	}
+
+private:
+	std::vector<std::uint8_t> tags;
+	std::vector<CPinfo> entries;
+	std::vector<char> arena;
+};
+
 #endif
@@ -0,0 +1,252 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Cache.h"
+#include "FileUtils.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC     0x4351444a // "JDQC"
+#define CACHE_HEADER    24 // magic, unused, payload length, payload hash
+#define STALE_TMP_AGE   3600 // seconds before an orphaned temporary file is removed
+
+static bool writeAll(int fd, const char * data, std::size_t length)
+{
+	while(length > 0)
+	{
+		ssize_t n = ::write(fd, data, length);
+		if(n < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			return false;
+		}
+		data += n;
+		length -= n;
+	}
+	return true;
+}
+
+DecompileCache::DecompileCache(const std::string & directory, std::uint64_t maxBytes)
+	: directory(directory), maxBytes(maxBytes), tmpCounter(0)
+{
+	open = makeDirectories(directory + "/tmp");
+	if(open)
+		evict(); // also gives a first estimation of the size
+}
+
+bool DecompileCache::isOpen() const
+{
+	return open;
+}
+
+std::string DecompileCache::makeKey(const std::uint8_t * data, std::size_t length, const std::string & salt)
+{
+	std::uint64_t seed1 = xxhash64(salt.data(), salt.size());
+	std::uint64_t seed2 = xxhash64(salt.data(), salt.size(), ~seed1);
+	
+	return toHex(xxhash64(data, length, seed1)) + toHex(xxhash64(data, length, seed2));
+}
+
+std::string DecompileCache::entryPath(const std::string & key) const
+{
+	return directory + "/" + key.substr(0, 2) + "/" + key;
+}
+
+bool DecompileCache::lookup(const std::string & key, std::string & text)
+{
+	if(!open)
+		return false;
+	
+	std::string path = entryPath(key);
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+	
+	bool found = false;
+	unsigned char header[CACHE_HEADER];
+	if(::read(fd, header, CACHE_HEADER) == CACHE_HEADER)
+	{
+		std::uint32_t magic;
+		std::uint64_t length, hash;
+		std::memcpy(&magic, header, 4);
+		std::memcpy(&length, header + 8, 8);
+		std::memcpy(&hash, header + 16, 8);
+		
+		// the length must be the rest of the file, a corrupted one could
+		// ask for any amount of memory
+		struct stat st;
+		if(magic == CACHE_MAGIC && fstat(fd, &st) == 0 && st.st_size >= CACHE_HEADER && length == static_cast<std::uint64_t>(st.st_size - CACHE_HEADER))
+		{
+			text.resize(length);
+			std::size_t done = 0;
+			ssize_t n = 1;
+			while(done < length && n > 0)
+			{
+				n = ::read(fd, &text[done], length - done);
+				if(n > 0)
+					done += n;
+			}
+			found = done == length && xxhash64(text.data(), text.size()) == hash;
+		}
+	}
+	
+	// a corrupted entry is left alone: another process may have just renamed
+	// a good one over the path, and the store() after this miss replaces it
+	// anyway, or else, never used again, it goes first in evict()
+	if(found)
+		futimens(fd, nullptr); // mark as recently used
+	else
+		text.clear();
+	
+	close(fd);
+	return found;
+}
+
+void DecompileCache::store(const std::string & key, const std::string & text)
+{
+	if(!open)
+		return;
+	
+	std::string tmp = directory + "/tmp/" + key + "." + std::to_string(getpid()) + "." + std::to_string(tmpCounter++);
+	int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if(fd < 0)
+		return;
+	
+	unsigned char header[CACHE_HEADER] = {0};
+	std::uint32_t magic = CACHE_MAGIC;
+	std::uint64_t length = text.size();
+	std::uint64_t hash = xxhash64(text.data(), text.size());
+	std::memcpy(header, &magic, 4);
+	std::memcpy(header + 8, &length, 8);
+	std::memcpy(header + 16, &hash, 8);
+	
+	bool written = writeAll(fd, reinterpret_cast<char *>(header), CACHE_HEADER) && writeAll(fd, text.data(), text.size());
+	close(fd);
+	
+	std::string path = entryPath(key);
+	if(!written || !makeDirectories(directory + "/" + key.substr(0, 2)) || rename(tmp.c_str(), path.c_str()) != 0)
+	{
+		unlink(tmp.c_str());
+		return;
+	}
+	
+	bool full;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentBytes += CACHE_HEADER + text.size();
+		full = currentBytes > maxBytes;
+	}
+	if(full)
+		evict();
+}
+
+void DecompileCache::evict()
+{
+	struct Entry {
+		struct timespec used;
+		std::uint64_t size;
+		std::string path;
+	};
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	
+	// only one process at a time walks the directory
+	std::string lockPath = directory + "/lock";
+	int lockFd = ::open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+	if(lockFd < 0)
+		return;
+	flock(lockFd, LOCK_EX);
+	
+	std::vector<Entry> entries;
+	std::uint64_t total = 0;
+	time_t now = time(nullptr);
+	
+	DIR * root = opendir(directory.c_str());
+	struct dirent * sub;
+	while(root && (sub = readdir(root)) != nullptr)
+	{
+		if(sub->d_name[0] == '.' || std::strcmp(sub->d_name, "lock") == 0)
+			continue;
+		
+		bool isTmp = std::strcmp(sub->d_name, "tmp") == 0;
+		std::string subPath = directory + "/" + sub->d_name;
+		DIR * dir = opendir(subPath.c_str());
+		struct dirent * file;
+		while(dir && (file = readdir(dir)) != nullptr)
+		{
+			if(file->d_name[0] == '.')
+				continue;
+			
+			std::string path = subPath + "/" + file->d_name;
+			struct stat st;
+			if(stat(path.c_str(), &st) != 0)
+				continue;
+			
+			if(isTmp)
+			{
+				if(now - st.st_mtime > STALE_TMP_AGE)
+					unlink(path.c_str());
+				continue;
+			}
+			
+			entries.push_back(Entry{st.st_mtim, static_cast<std::uint64_t>(st.st_size), path});
+			total += st.st_size;
+		}
+		if(dir)
+			closedir(dir);
+	}
+	if(root)
+		closedir(root);
+	
+	if(total > maxBytes)
+	{
+		std::sort(entries.begin(), entries.end(), [](const Entry & a, const Entry & b) {
+			return a.used.tv_sec < b.used.tv_sec || (a.used.tv_sec == b.used.tv_sec && a.used.tv_nsec < b.used.tv_nsec);
+		});
+		
+		// go a bit under the limit so we don't scan again on the next store
+		std::uint64_t target = maxBytes - maxBytes / 10;
+		for(std::size_t i = 0;i < entries.size() && total > target;i++)
+		{
+			if(unlink(entries[i].path.c_str()) == 0)
+				total -= entries[i].size;
+		}
+	}
+	
+	currentBytes = total;
+	
+	flock(lockFd, LOCK_UN);
+	close(lockFd);
+}
@@ -0,0 +1,63 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// on-disk cache of decompiled classes, keyed by the hash of the class bytes
+// entries are written to a temporary file and renamed in place, so several
+// threads or processes can share the same directory; once it grows past
+// maxBytes the least recently used entries are removed
+class DecompileCache
+{
+public:
+	DecompileCache(const std::string & directory, std::uint64_t maxBytes);
+	
+	bool isOpen() const;
+	
+	// salt must contain everything besides the bytes that changes the output
+	static std::string makeKey(const std::uint8_t * data, std::size_t length, const std::string & salt);
+	
+	bool lookup(const std::string & key, std::string & text);
+	void store(const std::string & key, const std::string & text);
+	void evict();
+
+private:
+	std::string entryPath(const std::string & key) const;
+	
+	std::string directory;
+	std::uint64_t maxBytes;
+	std::uint64_t currentBytes = 0; // estimation, corrected by evict()
+	bool open = false;
+	std::mutex mutex;
+	std::atomic<unsigned int> tmpCounter;
+};
+
+#endif
@@ -24,32 +24,74 @@ freely, subject to the following restrictions:
 */
 #include "ClassFile.h"
 #include "defines.h"
-#include <iostream>
+#include "Disassembler.h"
+#include "Diagnostics.h"
+#include "OpcodeInfo.h"
+#include "Stats.h"
+#include <cstring>
+#include <iterator>
 
 using namespace std;
 
 StreamReader::StreamReader()
+	: buffer(nullptr), size(0), pos(0), overrun(false)
 {
 }
 
-void StreamReader::setStream(std::ifstream * stream)
+void StreamReader::setBuffer(const std::uint8_t * data, std::size_t length)
 {
-	buffer = stream;
+	buffer = data;
+	size = length;
+	pos = 0;
+	overrun = false;
 }
 
-void StreamReader::readRawData(char * s, std::streamsize length)
+void StreamReader::readRawData(char * s, std::size_t length)
 {
-	buffer->read(s, length);
+	std::size_t available = remaining();
+	if(length > available)
+	{
+		// behave like a failed istream::read: what's missing is left untouched
+		overrun = true;
+		length = available;
+	}
+	if(length == 0)
+		return; // buffer may be null
+	std::memcpy(s, buffer + pos, length);
+	pos += length;
+}
+
+ByteView StreamReader::readView(std::size_t length)
+{
+	std::size_t available = remaining();
+	if(length > available)
+	{
+		overrun = true;
+		length = available;
+	}
+	ByteView view(reinterpret_cast<const char *>(buffer + pos), length);
+	pos += length;
+	return view;
 }
 
 int StreamReader::getPos()
 {
-	return buffer->tellg();
+	return static_cast<int>(pos);
+}
+
+std::size_t StreamReader::remaining()
+{
+	return size - pos;
+}
+
+bool StreamReader::good()
+{
+	return !overrun;
 }
 
 #define READ_BUFF(size) \
 	unsigned char s[size] = {0}; \
-	buffer->read(reinterpret_cast<char *>(s), size);
+	readRawData(reinterpret_cast<char *>(s), size);
 
 StreamReader& StreamReader::operator>>(std::int8_t & i)
 {
@@ -74,8 +116,9 @@ StreamReader& StreamReader::operator>>(std::int32_t & i)
 
 StreamReader& StreamReader::operator>>(std::int64_t & i)
 {
-	READ_BUFF(8)
-	i = 0LL;
+	std::uint64_t u;
+	*this >> u;
+	i = static_cast<std::int64_t>(u);
 	return *this;
 }
 
@@ -103,7 +146,9 @@ StreamReader& StreamReader::operator>>(std::uint32_t & u)
 StreamReader& StreamReader::operator>>(std::uint64_t & u)
 {
 	READ_BUFF(8)
-	u = 0ULL;
+	u = 0;
+	for(int b = 0;b < 8;b++)
+		u = u << 8 | s[b];
 	return *this;
 }
 
@@ -113,34 +158,58 @@ ClassFile::ClassFile(std::string filename)
 	if(!file.is_open())
 		return;
 	
-	stream.setStream(&file);
+	fileData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	file.close();
+	
+	parse(fileData.data(), fileData.size());
+}
+
+ClassFile::ClassFile(const std::uint8_t * data, std::size_t length)
+{
+	parse(data, length);
+}
+
+void ClassFile::parse(const std::uint8_t * data, std::size_t length)
+{
+	STATS_TIMER(STAGE_MEMBERS);
+	STATS_COUNT(COUNTER_BYTES, length);
+	stream.setBuffer(data, length);
+	output.pool = &constant_pool;
 	
 	std::uint32_t magic;
 	stream >> magic;
 	if(magic != 0xcafebabe)
 	{
-		cout << "magic number is " << std::hex << magic << endl;
+		DIAG(DIAG_ERROR, "magic number is " << std::hex << magic);
 		return;
 	}
 	
 	std::uint16_t major, minor;
 	stream >> minor >> major;
-	cout << "JAVA " << major << "." << minor << endl;
+	DIAG(DIAG_INFO, "JAVA " << major << "." << minor);
 	
 	std::uint16_t constant_pool_count;
 	stream >> constant_pool_count;
-	cout << constant_pool_count << " constants" << endl;
+	DIAG(DIAG_INFO, constant_pool_count << " constants");
 	
-	constant_pool.push_back(CPinfo()); // index 0 is invalid
-	for(std::size_t i = 1;i < constant_pool_count;i++)
 	{
-		if(parseConstant()) // return true if double or bigint
+		STATS_TIMER(STAGE_CONSTANT_POOL);
+		STATS_COUNT(COUNTER_CONSTANTS, constant_pool_count);
+		constant_pool.reserve(constant_pool_count);
+		constant_pool.add(0, CPinfo()); // index 0 is invalid
+		for(std::size_t i = 1;i < constant_pool_count && !malformed;i++)
 		{
-			constant_pool.push_back(CPinfo()); // double and bigint use 2 indexes
-			i++;
+			if(parseConstant()) // return true if double or bigint
+			{
+				constant_pool.add(0, CPinfo()); // double and bigint use 2 indexes
+				i++;
+			}
 		}
 	}
 	
+	if(malformed)
+		return;
+	
 	std::uint16_t access_flags, this_class, super_class;
 	stream >> access_flags >> this_class >> super_class;
 	
@@ -149,7 +218,7 @@ ClassFile::ClassFile(std::string filename)
 	if(access_flags & ACC_FINAL)
 		output.isFinal = true;
 	if(access_flags & ACC_SUPER)
-		cout << "is super, ignored." << endl;
+		DIAG(DIAG_DEBUG, "is super, ignored.");
 	if(access_flags & ACC_INTERFACE)
 		output.isInterface = true;
 	if(access_flags & ACC_ABSTRACT)
@@ -159,14 +228,28 @@ ClassFile::ClassFile(std::string filename)
 	if(access_flags & ACC_ENUM)
 		output.isEnum = true;
 	if(access_flags & (~0x0631))
-		cout << "ERROR: unrecognized flag(s)" << endl;
+		DIAG(DIAG_ERROR, "unrecognized class flag(s) " << std::hex << (access_flags & ~0x0631));
 	
-	output.name = getName(constant_pool[this_class].ClassInfo.name_index);
-	output.extends = checkClassName(getName(constant_pool[super_class].ClassInfo.name_index));
+	if(!className(this_class, output.name))
+	{
+		DIAG(DIAG_ERROR, "this_class #" << this_class << " is not a class");
+		return;
+	}
+	DIAG_CONTEXT(&output.name);
+	if(super_class == 0)
+		output.extends = "Object"; // java/lang/Object itself
+	else if(className(super_class, output.extends))
+		output.extends = checkClassName(std::move(output.extends));
+	else
+	{
+		DIAG(DIAG_ERROR, "super_class #" << super_class << " is not a class");
+		return;
+	}
 	
 	std::uint16_t interfaces_count;
 	stream >> interfaces_count;
-	cout << interfaces_count << " interfaces" << endl;
+	DIAG(DIAG_INFO, interfaces_count << " interfaces");
+	output.interfaces.reserve(interfaces_count);
 	for(std::uint16_t i = 0;i < interfaces_count;i++)
 	{
 		output.interfaces.push_back(parseInterface());
@@ -174,82 +257,187 @@ ClassFile::ClassFile(std::string filename)
 	
 	std::uint16_t fields_count;
 	stream >> fields_count;
-	cout << fields_count << " fields" << endl;
+	DIAG(DIAG_INFO, fields_count << " fields");
+	output.fields.reserve(fields_count);
 	for(std::uint16_t i = 0;i < fields_count;i++)
 	{
-		output.fields.push_back(parseField());
+		parseField();
 	}
 	
 	std::uint16_t methods_count;
 	stream >> methods_count;
-	cout << methods_count << " methods" << endl;
+	DIAG(DIAG_INFO, methods_count << " methods");
+	STATS_COUNT(COUNTER_METHODS, methods_count);
+	output.methods.reserve(methods_count);
 	for(std::uint16_t i = 0;i < methods_count;i++)
 	{
-		output.methods.push_back(parseMethod());
+		parseMethod();
 	}
 	
 	std::uint16_t attributes_count;
 	stream >> attributes_count;
-	cout << attributes_count << " attributes" << endl;
+	DIAG(DIAG_INFO, attributes_count << " attributes");
 	for(std::uint16_t i = 0;i < attributes_count;i++)
 	{
-		parseAttribute();
+		parseAttribute(nullptr);
 	}
 	
-	file.close();
+	valid = stream.good() && !malformed;
+}
+
+bool ClassFile::validDescriptor(std::uint16_t index, bool method) const
+{
+	if(index >= constant_pool.size() || constant_pool.tag(index) != CONSTANT_Utf8)
+		return false;
+	return isValidDescriptor(constant_pool.utf8(index), constant_pool.utf8Length(index), method);
 }
 
-ClassFile::~ClassFile()
+bool ClassFile::className(std::uint16_t index, std::string & name) const
 {
-	for(auto str : toDelete)
+	if(index >= constant_pool.size() || constant_pool.tag(index) != CONSTANT_Class)
+		return false;
+	std::uint16_t name_index = constant_pool[index].ClassInfo.name_index;
+	if(name_index >= constant_pool.size() || constant_pool.tag(name_index) != CONSTANT_Utf8)
+		return false;
+	name.assign(constant_pool.utf8(name_index), constant_pool.utf8Length(name_index));
+	return true;
+}
+
+bool ClassFile::validCode(ByteView attribute, std::uint16_t descriptor_index, bool isStatic) const
+{
+	if(attribute.size() < 8)
+	{
+		DIAG(DIAG_ERROR, "Code attribute is truncated");
+		return false;
+	}
+	
+	const unsigned char * bytes = reinterpret_cast<const unsigned char *>(attribute.data());
+	std::size_t maxLocals = bytes[2] << 8 | bytes[3];
+	std::size_t codeLength = static_cast<std::uint32_t>(readInt(bytes + 4));
+	if(codeLength == 0 || codeLength > attribute.size() - 8)
+	{
+		DIAG(DIAG_ERROR, "code length " << codeLength << " doesn't fit in its attribute");
+		return false;
+	}
+	
+	std::size_t parameterSlots = isStatic ? 0 : 1;
+	std::vector<std::string> parameters = parseSignature(constant_pool.utf8(descriptor_index));
+	for(std::size_t i = 0;i + 1 < parameters.size();i++)
+		parameterSlots += (parameters[i] == "long" || parameters[i] == "double") ? 2 : 1;
+	if(parameterSlots > maxLocals)
+	{
+		DIAG(DIAG_ERROR, "the parameters need " << parameterSlots << " locals, max_locals is " << maxLocals);
+		return false;
+	}
+	
+	const unsigned char * code = bytes + 8;
+	std::vector<bool> starts(codeLength, false);
+	std::vector<std::int64_t> targets;
+	for(std::size_t pc = 0, length;pc < codeLength;pc += length)
+	{
+		length = instructionLength(code, pc, codeLength);
+		if(length == 0)
+		{
+			DIAG_AT(DIAG_ERROR, pc, opcodeName(code[pc]) << " is truncated");
+			return false;
+		}
+		starts[pc] = true;
+		
+		unsigned char opcode = code[pc];
+		std::size_t local = 0;
+		bool hasLocal = true;
+		if(opcode >= OP_iload_0 && opcode <= OP_aload_3)
+			local = (opcode - OP_iload_0) % 4;
+		else if(opcode >= OP_istore_0 && opcode <= OP_astore_3)
+			local = (opcode - OP_istore_0) % 4;
+		else
+		{
+			hasLocal = false;
+			switch(opcodeInfo(opcode).operands)
+			{
+				case OPERAND_LOCAL:
+				case OPERAND_IINC:
+					local = code[pc + 1];
+					hasLocal = true;
+					break;
+				case OPERAND_WIDE:
+					local = code[pc + 2] << 8 | code[pc + 3];
+					hasLocal = true;
+					break;
+				case OPERAND_BRANCH2:
+					targets.push_back(static_cast<std::int64_t>(pc) + static_cast<std::int16_t>(code[pc + 1] << 8 | code[pc + 2]));
+					break;
+				case OPERAND_BRANCH4:
+					targets.push_back(static_cast<std::int64_t>(pc) + readInt(code + pc + 1));
+					break;
+				case OPERAND_SWITCH:
+					{
+						std::size_t base = pc + 1 + (4 - (pc + 1) % 4) % 4;
+						targets.push_back(static_cast<std::int64_t>(pc) + readInt(code + base));
+						// after default: low, high and the offsets, or npairs and the (match, offset) pairs
+						std::size_t step = opcode == OP_tableswitch ? 4 : 8;
+						for(std::size_t entry = base + 12;entry < pc + length;entry += step)
+							targets.push_back(static_cast<std::int64_t>(pc) + readInt(code + entry));
+					}
+					break;
+			}
+		}
+		if(hasLocal && local >= maxLocals)
+		{
+			DIAG_AT(DIAG_ERROR, pc, opcodeName(opcode) << " of local " << local << ", max_locals is " << maxLocals);
+			return false;
+		}
+	}
+	
+	for(std::int64_t target : targets)
 	{
-		delete[] str;
+		if(target < 0 || static_cast<std::size_t>(target) >= codeLength || !starts[target])
+		{
+			DIAG(DIAG_ERROR, "branch to " << target << " which isn't an instruction");
+			return false;
+		}
 	}
+	return true;
 }
 
-std::tuple<std::string, std::string> ClassFile::parseAttribute()
+void ClassFile::parseAttribute(MemberTable * table)
 {
 	std::uint16_t attribute_name_index;
 	stream >> attribute_name_index;
 	
-	std::string name = getName(attribute_name_index);
-	
 	std::uint32_t length;
 	stream >> length;
-	if(length > 512)
+	if(length > stream.remaining())
 	{
-		cerr << "attribute " << name << " has more than 512 bytes of data" << endl;
-		exit(1);
+		DIAG(DIAG_ERROR, "attribute " << getName(constant_pool, attribute_name_index) << " is truncated");
+		length = stream.remaining();
 	}
 	
-	char tmp[512] = {0};
-	stream.readRawData(tmp, length);
-	std::string data(tmp, length);
-	
-	return std::make_tuple(name, data);
+	ByteView data = stream.readView(length);
+	if(table)
+		table->addAttribute(attribute_name_index, data);
 }
 
 bool ClassFile::parseConstant()
 {
 	bool isDoubleSize = false;
 	
-	CPinfo info;
+	CPinfo info = CPinfo();
+	std::uint8_t tag;
 	
-	stream >> info.tag;
+	stream >> tag;
 	
-	switch(info.tag)
+	switch(tag)
 	{
 		case CONSTANT_Utf8:
 			{
 				std::uint16_t length;
 				stream >> length;
-				char * string = new char[length+1];
-				stream.readRawData(string, length);
-				string[length] = 0;
-				info.UTF8Info.bytes = string;
-				toDelete.push_back(string);
+				ByteView bytes = stream.readView(length);
+				if(!constant_pool.addUtf8(bytes.data(), bytes.size()))
+					DIAG(DIAG_ERROR, "constant #" << constant_pool.size() - 1 << " is not valid modified UTF-8");
 			}
-			break;
+			return false;
 		case CONSTANT_Integer:
 			stream >> info.IntegerInfo.bytes;
 			break;
@@ -298,56 +486,42 @@ bool ClassFile::parseConstant()
 			stream >> info.InvokeDynamicInfo.name_and_type_index;
 			break;
 		default:
-			cerr << "ERROR: unrecognize TAG" << endl;
-			exit(1);
+			// nothing after it can be located, the class is invalid
+			DIAG(DIAG_ERROR, "unrecognized constant tag " << static_cast<int>(tag));
+			malformed = true;
+			return false;
 	}
 	
-	constant_pool.push_back(info);
+	constant_pool.add(tag, info);
 	
 	return isDoubleSize;
 }
 
-FieldOutput ClassFile::parseField()
+void ClassFile::parseField()
 {
-	FieldOutput field;
-	
 	std::uint16_t access_flags, name_index, descriptor_index;
 	stream >> access_flags >> name_index >> descriptor_index;
+	output.fields.add(access_flags, name_index, descriptor_index);
+	if(!validDescriptor(descriptor_index, false))
+	{
+		DIAG(DIAG_ERROR, "field " << getName(constant_pool, name_index) << " has the invalid descriptor " << getName(constant_pool, descriptor_index));
+		malformed = true;
+	}
 	
-	field.name = getName(name_index);
-	int i = 0;
-	field.type = parseType(getName(descriptor_index), i);
-	
-	if(access_flags & ACC_PUBLIC)
-		field.isPublic = true;
-	if(access_flags & ACC_PRIVATE)
-		field.isPrivate = true;
-	if(access_flags & ACC_PROTECTED)
-		field.isProtected = true;
-	if(access_flags & ACC_STATIC)
-		field.isStatic = true;
-	if(access_flags & ACC_FINAL)
-		field.isFinal = true;
-	if(access_flags & ACC_VOLATILE)
-		field.isVolatile = true;
-	if(access_flags & ACC_TRANSIENT)
-		field.isTransient = true;
 	if(access_flags & ACC_SYNTHETIC)
-		cout << "Declared synthetic; not present in the source code." << endl;
+		DIAG(DIAG_DEBUG, "Declared synthetic; not present in the source code.");
 	if(access_flags & ACC_ENUM)
-		cout << "is part of an enum." << endl;
+		DIAG(DIAG_DEBUG, "is part of an enum.");
 	if(access_flags & ~ACC_FIELD_MASK)
-		cerr << "ERROR: unrecognized flag(s)" << endl;
+		DIAG(DIAG_ERROR, "unrecognized field flag(s) " << std::hex << (access_flags & ~ACC_FIELD_MASK));
 	
 	std::uint16_t attributes_count;
 	stream >> attributes_count;
-	cout << "- " << attributes_count << " attributes" << endl;
+	DIAG(DIAG_DEBUG, "- " << attributes_count << " attributes");
 	for(std::uint16_t i = 0;i < attributes_count;i++)
 	{
-		field.attributes.push_back(parseAttribute());
+		parseAttribute(&output.fields);
 	}
-	
-	return field;
 }
 
 std::string ClassFile::parseInterface()
@@ -356,66 +530,55 @@ std::string ClassFile::parseInterface()
 	std::string interfaceName;
 	
 	stream >> name_index;
-	CPinfo *data = &constant_pool[name_index];
-	if(data->tag == CONSTANT_Class)
-	{
-		interfaceName = getName(data->ClassInfo.name_index);
-	}
-	else
+	if(!className(name_index, interfaceName))
 	{
-		cerr << "ERROR: index " << name_index << " in not a class" << endl;
+		DIAG(DIAG_ERROR, "index " << name_index << " is not a class");
+		malformed = true;
 	}
 	
 	return interfaceName;
 }
 
-MethodOutput ClassFile::parseMethod()
+void ClassFile::parseMethod()
 {
-	MethodOutput method;
-	
 	std::uint16_t access_flags, name_index, descriptor_index;
 	stream >> access_flags >> name_index >> descriptor_index;
-	method.name = getName(name_index);
+	output.methods.add(access_flags, name_index, descriptor_index);
+	if(!validDescriptor(descriptor_index, true))
+	{
+		DIAG(DIAG_ERROR, "method " << getName(constant_pool, name_index) << " has the invalid descriptor " << getName(constant_pool, descriptor_index));
+		malformed = true;
+	}
 	
-	if(access_flags & ACC_PUBLIC)
-		method.isPublic = true;
-	if(access_flags & ACC_PRIVATE)
-		method.isPrivate = true;
-	if(access_flags & ACC_PROTECTED)
-		method.isProtected = true;
-	if(access_flags & ACC_STATIC)
-		method.isStatic = true;
-	if(access_flags & ACC_FINAL)
-		method.isFinal = true;
-	if(access_flags & ACC_SYNCHRONIZED)
-		method.isSynchronized = true;
-	if(access_flags & ACC_BRIDGE)
-		method.isBridge = true;
-	if(access_flags & ACC_VARARGS)
-		method.isVarargs = true;
-	if(access_flags & ACC_NATIVE)
-		method.isNative = true;
-	if(access_flags & ACC_ABSTRACT)
-		method.isAbstract = true;
-	if(access_flags & ACC_STRICT)
-		method.isStrict = true;
 	if(access_flags & ACC_SYNTHETIC)
-		cout << "Declared synthetic; not present in the source code." << endl;
+		DIAG(DIAG_DEBUG, "Declared synthetic; not present in the source code.");
 	if(access_flags & ~ACC_METHOD_MASK)
-		cerr << "ERROR: unrecognized flag(s)" << endl;
-	
-	method.parametersType = parseSignature(getName(descriptor_index));
-	method.returnType = method.parametersType.back();
-	method.parametersType.pop_back();
+		DIAG(DIAG_ERROR, "unrecognized method flag(s) " << std::hex << (access_flags & ~ACC_METHOD_MASK));
 	
 	std::uint16_t attributes_count;
 	stream >> attributes_count;
 	for(std::uint16_t i = 0;i < attributes_count;i++)
 	{
-		method.attributes.push_back(parseAttribute());
+		parseAttribute(&output.methods);
 	}
 	
-	return method;
+	if(malformed)
+		return;
+	std::size_t method = output.methods.size() - 1;
+	for(std::size_t i = output.methods.attributeBegin(method);i < output.methods.attributeEnd(method);i++)
+	{
+		const MemberTable::Attribute & attribute = output.methods.attributes[i];
+		if(getName(constant_pool, attribute.nameIndex) == "Code" && !validCode(attribute.data, descriptor_index, access_flags & ACC_STATIC))
+		{
+			DIAG(DIAG_ERROR, "method " << getName(constant_pool, name_index) << " has invalid code");
+			malformed = true;
+		}
+	}
+}
+
+bool ClassFile::isValid() const
+{
+	return valid;
 }
 
 void ClassFile::generate()
@@ -424,6 +587,27 @@ void ClassFile::generate()
 	if(!file.is_open())
 		return;
 	
-	output.generate(file);
+	generate(file);
+}
+
+void ClassFile::disassemble(std::ostream & file)
+{
+	disassembleClass(output, file);
+}
+
+unsigned ClassFile::writeModel(std::ostream & file, ModelEncoding encoding)
+{
+	return ::writeModel(output, encoding, file);
+}
+
+void ClassFile::setBudgets(const Budget & method, const Budget & cls)
+{
+	output.methodBudget = method;
+	output.classBudget = cls;
+}
+
+unsigned ClassFile::generate(std::ostream & file, MethodMemo * memo)
+{
+	return output.generate(file, memo);
 }
 
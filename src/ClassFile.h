@@ -25,6 +25,7 @@ freely, subject to the following restrictions:
 #ifndef CLASSFILE_H
 #define CLASSFILE_H
 
+#include <cstdint>
 #include <fstream>
 #include <map>
 #include <string>
@@ -34,14 +35,19 @@ freely, subject to the following restrictions:
 #include "ClassOutput.h"
 #include "CPinfo.h"
 #include "Helpers.h"
+#include "ModelWriter.h"
 
 class StreamReader
 {
 public:
 	StreamReader();
-	void setStream(std::ifstream * stream);
-	void readRawData(char * s, std::streamsize length);
+	void setBuffer(const std::uint8_t * data, std::size_t length);
+	void readRawData(char * s, std::size_t length);
+	// the next length bytes, left in the buffer
+	ByteView readView(std::size_t length);
 	int getPos();
+	std::size_t remaining();
+	bool good();
 	
 	StreamReader& operator>>(std::int8_t & i);
 	StreamReader& operator>>(std::int16_t & i);
@@ -53,30 +59,54 @@ public:
 	StreamReader& operator>>(std::uint64_t & u);
 	
 private:
-	std::ifstream * buffer;
+	const std::uint8_t * buffer;
+	std::size_t size;
+	std::size_t pos;
+	bool overrun;
 };
 
 class ClassFile
 {
 public:
 	ClassFile(std::string filename);
-	~ClassFile();
+	// the buffer must outlive the ClassFile, the attributes point into it
+	ClassFile(const std::uint8_t * data, std::size_t length);
+	ClassFile(const ClassFile &) = delete;
+	ClassFile & operator=(const ClassFile &) = delete;
 	
+	bool isValid() const;
 	void generate();
+	void disassemble(std::ostream & file);
+	// returns the number of methods replaced by stubs
+	unsigned writeModel(std::ostream & file, ModelEncoding encoding);
+	void setBudgets(const Budget & method, const Budget & cls);
+	// returns the number of methods replaced by stubs
+	unsigned generate(std::ostream & file, MethodMemo * memo = nullptr);
 
 private:
 	ClassOutput output;
-	
-	std::vector<char *> toDelete; // find a better way (see (1))
+	ConstantPool constant_pool;
+	std::vector<std::uint8_t> fileData; // the buffer when read from a file
 	
 	StreamReader stream;
+	bool valid = false;
+	bool malformed = false; // stops the parsing
 	
 	// functions
-	std::tuple<std::string, std::string> parseAttribute();
+	void parse(const std::uint8_t * data, std::size_t length);
+	// added to the last member of table, if any
+	void parseAttribute(MemberTable * table);
 	bool parseConstant();
-	FieldOutput parseField();
+	void parseField();
 	std::string parseInterface();
-	MethodOutput parseMethod();
+	void parseMethod();
+	// a field descriptor, or a method one, in the constant pool
+	bool validDescriptor(std::uint16_t index, bool method) const;
+	// the name of the CONSTANT_Class at index, false if there is none
+	bool className(std::uint16_t index, std::string & name) const;
+	// what the decoder relies on: instructions which fit in the code, branch
+	// targets on instruction starts, locals and parameters under max_locals
+	bool validCode(ByteView attribute, std::uint16_t descriptor_index, bool isStatic) const;
 };
 
 #endif
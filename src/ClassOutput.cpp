@@ -23,12 +23,22 @@ freely, subject to the following restrictions:
    distribution.
 */
 #include "ClassOutput.h"
-#include <fstream>
+#include "Helpers.h"
+#include "MethodMemo.h"
+#include "Stats.h"
+#include <ostream>
+#include <sstream>
+#include <utility>
+#include <vector>
 
 #define W(c) file << c
 
-void ClassOutput::generate(std::ofstream & file)
+unsigned ClassOutput::generate(std::ostream & file, MethodMemo * memo)
 {
+	STATS_TIMER(STAGE_EMIT);
+	BudgetMeter classMeter(classBudget);
+	unsigned stubs = 0;
+	
 	if(isPublic)
 		W("public ");
 	if(isAbstract)
@@ -60,17 +70,115 @@ void ClassOutput::generate(std::ofstream & file)
 	}
 	W(" {\n");
 	
-	for(MethodOutput m : methods)
+	for(std::size_t i = 0;i < methods.size();i++)
 	{
-		m.thisClass = name;
-		m.parentClass = extends;
-		m.generate(file);
+		// built and released a method at a time
+		MethodOutput m = method(i);
+		m.budget = &methodBudget;
+		m.classMeter = classBudget.isSet() ? &classMeter : nullptr;
+		
+		if(memo)
+		{
+			std::string key = m.memoKey();
+			MethodMemo::Entry entry;
+			std::uint32_t * opcodes = STATS_OPCODES();
+			// a hit costs the class what generating the method would have;
+			// once that's too much, generate() writes the stub
+			if(memo->lookup(key, entry) && !(m.classMeter && m.classMeter->spend(entry.instructions, entry.bytes)))
+			{
+				STATS_COUNT(COUNTER_INSTRUCTIONS, entry.instructions);
+				if(opcodes)
+				{
+					for(const auto & count : entry.opcodes)
+						opcodes[count.first] += count.second;
+				}
+				W(m.memoRestore(entry.text));
+			}
+			else
+			{
+				entry = MethodMemo::Entry();
+				std::vector<std::uint32_t> before;
+				if(opcodes)
+					before.assign(opcodes, opcodes + 256);
+				
+				std::ostringstream buffer;
+				// a stub depends on the budgets and the timing, not only on the key
+				if(m.generate(buffer))
+				{
+					entry.text = m.memoText(buffer.str());
+					entry.instructions = m.decodedInstructions;
+					entry.bytes = m.decodedBytes;
+					for(std::size_t opcode = 0;opcodes && opcode < 256;opcode++)
+					{
+						if(opcodes[opcode] != before[opcode])
+							entry.opcodes.push_back(std::make_pair(static_cast<std::uint8_t>(opcode), opcodes[opcode] - before[opcode]));
+					}
+					memo->store(key, entry);
+				}
+				else
+				{
+					stubs++;
+				}
+				W(buffer.str());
+			}
+		}
+		else if(!m.generate(file))
+		{
+			stubs++;
+		}
+		// the sink gets each method as soon as it is done, not once the
+		// class is
+		file.flush();
 	}
 	
-	for(FieldOutput f : fields)
+	for(std::size_t i = 0;i < fields.size();i++)
 	{
-		f.generate(file);
+		field(i).generate(file);
 	}
 	
 	W("}\n");
+	return stubs;
+}
+
+MethodOutput ClassOutput::method(std::size_t i) const
+{
+	const ConstantPool & constant_pool = *pool;
+	MethodOutput m;
+	m.name = getName(constant_pool, methods.nameIndex[i]);
+	m.accessFlags = methods.accessFlags[i];
+	m.parametersType = parseSignature(getName(constant_pool, methods.descriptorIndex[i]));
+	m.returnType = std::move(m.parametersType.back());
+	m.parametersType.pop_back();
+	
+	std::size_t end = methods.attributeEnd(i);
+	m.attributes.reserve(end - methods.attributeBegin(i));
+	for(std::size_t a = methods.attributeBegin(i);a < end;a++)
+	{
+		const MemberTable::Attribute & attribute = methods.attributes[a];
+		m.attributes.emplace_back(getName(constant_pool, attribute.nameIndex), attribute.data);
+	}
+	
+	m.thisClass = name;
+	m.parentClass = extends;
+	m.pool = pool;
+	return m;
+}
+
+FieldOutput ClassOutput::field(std::size_t i) const
+{
+	const ConstantPool & constant_pool = *pool;
+	FieldOutput f;
+	f.name = getName(constant_pool, fields.nameIndex[i]);
+	f.accessFlags = fields.accessFlags[i];
+	int pos = 0;
+	f.type = parseType(getName(constant_pool, fields.descriptorIndex[i]), pos);
+	
+	std::size_t end = fields.attributeEnd(i);
+	f.attributes.reserve(end - fields.attributeBegin(i));
+	for(std::size_t a = fields.attributeBegin(i);a < end;a++)
+	{
+		const MemberTable::Attribute & attribute = fields.attributes[a];
+		f.attributes.emplace_back(getName(constant_pool, attribute.nameIndex), attribute.data);
+	}
+	return f;
 }
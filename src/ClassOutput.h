@@ -25,22 +25,33 @@ freely, subject to the following restrictions:
 #ifndef CLASSOUTPUT_H
 #define CLASSOUTPUT_H
 
+#include <ostream>
 #include <string>
 #include <vector>
 
+#include "MemberTable.h"
 #include "MethodOutput.h"
 #include "FieldOutput.h"
 
+class MethodMemo;
+
 class ClassOutput
 {
 public:
-	void generate(std::ofstream & file);
+	// returns the number of methods replaced by stubs for running out of budget
+	unsigned generate(std::ostream & file, MethodMemo * memo = nullptr);
+	// built from the tables on each call; the budgets are left to the caller
+	MethodOutput method(std::size_t i) const;
+	FieldOutput field(std::size_t i) const;
 	
 	std::string name;
 	std::string extends;
 	std::vector<std::string> interfaces;
-	std::vector<MethodOutput> methods;
-	std::vector<FieldOutput> fields;
+	MemberTable methods;
+	MemberTable fields;
+	const ConstantPool * pool = nullptr;
+	Budget methodBudget;
+	Budget classBudget;
 	bool isFinal = false,
 		 isAbstract = false,
 		 isInterface = false,
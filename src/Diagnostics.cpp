@@ -0,0 +1,132 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Diagnostics.h"
+#include "Json.h"
+#include <iostream>
+#include <mutex>
+
+int diagnosticsLevel = DIAG_OFF;
+
+namespace {
+
+const std::size_t FLUSH_BYTES = 1 << 16; // per thread
+
+const char * levelNames[] = {"error", "warning", "info", "debug"};
+
+std::mutex outputMutex;
+std::ostream * output = &std::cerr;
+
+thread_local const std::string * currentClass = nullptr;
+thread_local const std::string * currentMethod = nullptr;
+
+struct DiagnosticsBuffer
+{
+	std::string lines;
+	
+	void flush()
+	{
+		if(lines.empty())
+			return;
+		
+		std::lock_guard<std::mutex> lock(outputMutex);
+		output->write(lines.data(), lines.size());
+		output->flush();
+		lines.clear();
+	}
+	
+	~DiagnosticsBuffer()
+	{
+		flush();
+	}
+};
+
+thread_local DiagnosticsBuffer buffer;
+
+}
+
+void setDiagnosticsLevel(int level)
+{
+	diagnosticsLevel = level;
+}
+
+bool parseDiagnosticsLevel(const std::string & name, int & level)
+{
+	if(name == "off")
+	{
+		level = DIAG_OFF;
+		return true;
+	}
+	for(int i = DIAG_ERROR;i <= DIAG_DEBUG;i++)
+	{
+		if(name == levelNames[i])
+		{
+			level = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void setDiagnosticsOutput(std::ostream * out)
+{
+	std::lock_guard<std::mutex> lock(outputMutex);
+	output = out;
+}
+
+void flushDiagnostics()
+{
+	buffer.flush();
+}
+
+void writeDiagnostic(int level, int pc, const std::string & message)
+{
+	std::string & lines = buffer.lines;
+	lines += "{\"level\":\"";
+	lines += levelNames[level];
+	lines += '"';
+	if(currentClass && !currentClass->empty())
+		lines += ",\"class\":" + jsonString(*currentClass);
+	if(currentMethod && !currentMethod->empty())
+		lines += ",\"method\":" + jsonString(*currentMethod);
+	if(pc >= 0)
+		lines += ",\"pc\":" + std::to_string(pc);
+	lines += ",\"message\":" + jsonString(message) + "}\n";
+	
+	if(lines.size() >= FLUSH_BYTES)
+		buffer.flush();
+}
+
+DiagnosticsContext::DiagnosticsContext(const std::string * className, const std::string * methodName)
+	: previousClass(currentClass), previousMethod(currentMethod)
+{
+	currentClass = className;
+	currentMethod = methodName;
+}
+
+DiagnosticsContext::~DiagnosticsContext()
+{
+	currentClass = previousClass;
+	currentMethod = previousMethod;
+}
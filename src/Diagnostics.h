@@ -0,0 +1,90 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// messages about the classes being decompiled (malformed input, unsupported
+// bytecode, parsing progress), written as JSON lines:
+// {"level":"warning","class":"a/B","method":"run","pc":12,"message":"..."}
+// nothing is formatted unless the level is enabled, and each thread keeps its
+// lines in its own buffer, written out whole so that threads don't interleave
+
+enum DiagnosticsLevel
+{
+	DIAG_OFF = -1, // the default
+	DIAG_ERROR = 0, // malformed class file
+	DIAG_WARNING, // valid bytecode which is not decompiled properly
+	DIAG_INFO, // parsing progress
+	DIAG_DEBUG
+};
+
+extern int diagnosticsLevel;
+
+void setDiagnosticsLevel(int level);
+// "off", "error", "warning", "info" or "debug"
+bool parseDiagnosticsLevel(const std::string & name, int & level);
+// std::cerr by default; the stream must outlive the last flushDiagnostics()
+void setDiagnosticsOutput(std::ostream * out);
+// writes the lines buffered by the calling thread; threads flush by
+// themselves when they end
+void flushDiagnostics();
+
+void writeDiagnostic(int level, int pc, const std::string & message);
+
+// class and method the diagnostics of the calling thread are about, until the
+// end of the scope; the strings may be filled in later, but must outlive it
+class DiagnosticsContext
+{
+public:
+	DiagnosticsContext(const std::string * className, const std::string * methodName = nullptr);
+	~DiagnosticsContext();
+
+private:
+	const std::string * previousClass;
+	const std::string * previousMethod;
+};
+
+#define DIAG_CONCAT_(a, b) a##b
+#define DIAG_CONCAT(a, b) DIAG_CONCAT_(a, b)
+#define DIAG_CONTEXT(...) DiagnosticsContext DIAG_CONCAT(diagnosticsContext, __LINE__)(__VA_ARGS__)
+
+// DIAG_AT(DIAG_WARNING, pc, "unhandled opcode " << c), DIAG() when there is no pc
+#define DIAG_AT(level, pc, message) \
+	do \
+	{ \
+		if((level) <= diagnosticsLevel) \
+		{ \
+			std::ostringstream diagnosticsMessage; \
+			diagnosticsMessage << message; \
+			writeDiagnostic((level), (pc), diagnosticsMessage.str()); \
+		} \
+	} while(0)
+#define DIAG(level, message) DIAG_AT(level, -1, message)
+
+#endif
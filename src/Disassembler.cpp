@@ -0,0 +1,577 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Disassembler.h"
+#include "Helpers.h"
+#include "NumberFormat.h"
+#include "OpcodeInfo.h"
+#include "Stats.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// the lines are formatted straight into a buffer, written out in large
+// blocks rather than through the formatting of std::ostream
+class LineWriter
+{
+public:
+	LineWriter(std::ostream & file)
+		: file(file)
+	{
+	}
+	
+	~LineWriter()
+	{
+		flush();
+	}
+	
+	template<typename... Args>
+	void printf(const char * format, Args... args)
+	{
+		if(sizeof(buffer) - used < MAX_LINE)
+			flush();
+		int length = std::snprintf(buffer + used, sizeof(buffer) - used, format, args...);
+		if(length > 0)
+			used += std::min<std::size_t>(length, sizeof(buffer) - used - 1);
+	}
+	
+	void write(const char * text, std::size_t length)
+	{
+		if(length > sizeof(buffer) - used)
+		{
+			flush();
+			if(length > sizeof(buffer))
+			{
+				file.write(text, length);
+				return;
+			}
+		}
+		std::memcpy(buffer + used, text, length);
+		used += length;
+	}
+	
+	// right aligned in width columns; printf is much slower for these
+	void number(long long value, int width = 0)
+	{
+		char digits[24];
+		int count = 0;
+		unsigned long long magnitude = value < 0 ? 0 - static_cast<unsigned long long>(value) : value;
+		do
+		{
+			digits[count++] = '0' + magnitude % 10;
+			magnitude /= 10;
+		} while(magnitude);
+		if(value < 0)
+			digits[count++] = '-';
+		
+		reserve(width + count);
+		for(int i = count;i < width;i++)
+			buffer[used++] = ' ';
+		while(count)
+			buffer[used++] = digits[--count];
+	}
+	
+	// left aligned in width columns
+	void padded(const char * text, int width)
+	{
+		std::size_t length = std::strlen(text);
+		write(text, length);
+		reserve(width);
+		for(std::size_t i = length;i < static_cast<std::size_t>(width);i++)
+			buffer[used++] = ' ';
+	}
+	
+	void write(char c)
+	{
+		reserve(1);
+		buffer[used++] = c;
+	}
+	
+	void write(const std::string & text)
+	{
+		write(text.data(), text.size());
+	}
+	
+	void write(const char * text)
+	{
+		write(text, std::strlen(text));
+	}
+	
+	void flush()
+	{
+		file.write(buffer, used);
+		used = 0;
+	}
+
+private:
+	static const std::size_t MAX_LINE = 512; // longer lines are cut
+	
+	void reserve(std::size_t length)
+	{
+		if(length > sizeof(buffer) - used)
+			flush();
+	}
+	
+	std::ostream & file;
+	char buffer[1 << 15];
+	std::size_t used = 0;
+};
+
+std::uint16_t u2(const unsigned char * p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+std::int32_t s4(const unsigned char * p)
+{
+	return static_cast<std::int32_t>((std::uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+}
+
+std::string utf8(const ConstantPool & pool, std::uint16_t index)
+{
+	if(index == 0 || index >= pool.size() || pool.tag(index) != CONSTANT_Utf8)
+		return "?";
+	return std::string(pool.utf8(index), pool.utf8Length(index));
+}
+
+// keeps a listing line on one line
+std::string quote(const std::string & text)
+{
+	std::string quoted = "\"";
+	for(char c : text)
+	{
+		switch(c)
+		{
+			case '"': quoted += "\\\""; break;
+			case '\\': quoted += "\\\\"; break;
+			case '\n': quoted += "\\n"; break;
+			case '\r': quoted += "\\r"; break;
+			case '\t': quoted += "\\t"; break;
+			default:
+				if(static_cast<unsigned char>(c) < 0x20)
+				{
+					char escape[8];
+					std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+					quoted += escape;
+				}
+				else
+				{
+					quoted += c;
+				}
+		}
+	}
+	return quoted + "\"";
+}
+
+// what javap puts in the comment of an instruction
+std::string describeConstant(const ConstantPool & pool, std::uint16_t index)
+{
+	if(index == 0 || index >= pool.size())
+		return "invalid constant";
+	
+	const CPinfo & info = pool[index];
+	std::uint8_t tag = pool.tag(index);
+	switch(tag)
+	{
+		case CONSTANT_Utf8:
+			return std::string(pool.utf8(index), pool.utf8Length(index));
+		case CONSTANT_Integer:
+			return "int " + std::to_string(static_cast<std::int32_t>(info.IntegerInfo.bytes));
+		case CONSTANT_Float:
+			{
+				float value;
+				std::memcpy(&value, &info.FloatInfo.bytes, sizeof(value));
+				return "float " + formatFloat(value);
+			}
+		case CONSTANT_Long:
+			return "long " + std::to_string(static_cast<std::int64_t>(info.BigIntInfo.bytes));
+		case CONSTANT_Double:
+			{
+				double value;
+				std::memcpy(&value, &info.DoubleInfo.bytes, sizeof(value));
+				return "double " + formatDouble(value);
+			}
+		case CONSTANT_Class:
+			return "class " + utf8(pool, info.ClassInfo.name_index);
+		case CONSTANT_String:
+			return "String " + quote(utf8(pool, info.StringInfo.string_index));
+		case CONSTANT_Fieldref:
+		case CONSTANT_Methodref:
+		case CONSTANT_InterfaceMethodref:
+			{
+				const char * kind = tag == CONSTANT_Fieldref ? "Field " : tag == CONSTANT_Methodref ? "Method " : "InterfaceMethod ";
+				std::uint16_t classIndex = info.RefInfo.class_index;
+				std::string owner = classIndex < pool.size() && pool.tag(classIndex) == CONSTANT_Class ? utf8(pool, pool[classIndex].ClassInfo.name_index) : "?";
+				std::uint16_t nameAndType = info.RefInfo.name_and_type_index;
+				if(nameAndType >= pool.size() || pool.tag(nameAndType) != CONSTANT_NameAndType)
+					return kind + owner + ".?";
+				return kind + owner + "." + utf8(pool, pool[nameAndType].NameAndTypeInfo.name_index) + ":" + utf8(pool, pool[nameAndType].NameAndTypeInfo.descriptor_index);
+			}
+		case CONSTANT_NameAndType:
+			return utf8(pool, info.NameAndTypeInfo.name_index) + ":" + utf8(pool, info.NameAndTypeInfo.descriptor_index);
+		case CONSTANT_MethodHandle:
+			return "MethodHandle " + std::to_string(info.MethodHandleInfo.reference_kind) + ":" + describeConstant(pool, info.MethodHandleInfo.reference_index);
+		case CONSTANT_MethodType:
+			return "MethodType " + utf8(pool, info.MethodTypeInfo.descriptor_index);
+		case CONSTANT_InvokeDynamic:
+			{
+				std::uint16_t nameAndType = info.InvokeDynamicInfo.name_and_type_index;
+				std::string target = nameAndType < pool.size() && pool.tag(nameAndType) == CONSTANT_NameAndType ? describeConstant(pool, nameAndType) : "?";
+				return "InvokeDynamic #" + std::to_string(info.InvokeDynamicInfo.bootstrap_method_attr_index) + ":" + target;
+			}
+	}
+	return "unknown constant";
+}
+
+const char * mnemonic(unsigned char opcode)
+{
+	const char * name = opcodeInfo(opcode).mnemonic;
+	return name ? name : "undefined";
+}
+
+// the comments of the instructions, each constant being described once
+class ConstantNames
+{
+public:
+	ConstantNames(const ConstantPool & pool)
+		: pool(pool), names(pool.size())
+	{
+	}
+	
+	const std::string & operator[](std::uint16_t index)
+	{
+		if(index >= names.size())
+			return invalid;
+		if(names[index].empty())
+			names[index] = describeConstant(pool, index);
+		return names[index];
+	}
+	
+	const ConstantPool & constants() const
+	{
+		return pool;
+	}
+
+private:
+	const ConstantPool & pool;
+	std::vector<std::string> names;
+	std::string invalid = "invalid constant";
+};
+
+void writeConstantOperand(LineWriter & out, ConstantNames & pool, std::uint16_t index, const char * extra = "")
+{
+	char operand[32];
+	std::snprintf(operand, sizeof(operand), "#%u%s", index, extra);
+	out.padded(operand, 18);
+	out.write("// ");
+	out.write(pool[index]);
+	out.write("\n");
+}
+
+// one instruction, without its end of line for the switches
+void writeInstruction(LineWriter & out, ConstantNames & pool, const unsigned char * code, std::size_t pc, std::size_t length)
+{
+	unsigned char opcode = code[pc];
+	const OpcodeInfo & info = opcodeInfo(opcode);
+	const unsigned char * operands = code + pc + 1;
+	if(info.operands == OPERAND_NONE)
+	{
+		out.number(pc, 8);
+		out.write(": ");
+		out.write(mnemonic(opcode));
+		out.write('\n');
+		return;
+	}
+	out.number(pc, 8);
+	out.write(": ");
+	out.padded(mnemonic(opcode), 15);
+	
+	switch(info.operands)
+	{
+		case OPERAND_BYTE:
+			out.number(static_cast<signed char>(operands[0]));
+			out.write('\n');
+			break;
+		case OPERAND_SHORT:
+			out.number(static_cast<std::int16_t>(u2(operands)));
+			out.write('\n');
+			break;
+		case OPERAND_LOCAL:
+			out.number(operands[0]);
+			out.write('\n');
+			break;
+		case OPERAND_CONSTANT1:
+			writeConstantOperand(out, pool, operands[0]);
+			break;
+		case OPERAND_CONSTANT2:
+			writeConstantOperand(out, pool, u2(operands));
+			break;
+		case OPERAND_BRANCH2:
+			out.number(static_cast<long>(pc) + static_cast<std::int16_t>(u2(operands)));
+			out.write('\n');
+			break;
+		case OPERAND_BRANCH4:
+			out.number(static_cast<long>(pc) + s4(operands));
+			out.write('\n');
+			break;
+		case OPERAND_IINC:
+			out.number(operands[0]);
+			out.write(", ");
+			out.number(static_cast<signed char>(operands[1]));
+			out.write('\n');
+			break;
+		case OPERAND_INVOKEINTERFACE:
+			{
+				char count[16];
+				std::snprintf(count, sizeof(count), ", %u", operands[2]);
+				writeConstantOperand(out, pool, u2(operands), count);
+			}
+			break;
+		case OPERAND_INVOKEDYNAMIC:
+			writeConstantOperand(out, pool, u2(operands), ", 0");
+			break;
+		case OPERAND_ARRAY_TYPE:
+			out.write(typeFromInt(operands[0]));
+			out.write("\n");
+			break;
+		case OPERAND_MULTIANEWARRAY:
+			{
+				char dimensions[16];
+				std::snprintf(dimensions, sizeof(dimensions), ", %u", operands[2]);
+				writeConstantOperand(out, pool, u2(operands), dimensions);
+			}
+			break;
+		case OPERAND_SWITCH:
+			{
+				const unsigned char * table = code + pc + 1 + (4 - (pc + 1) % 4) % 4;
+				long defaultTarget = static_cast<long>(pc) + s4(table);
+				if(opcode == OP_tableswitch)
+				{
+					std::int32_t low = s4(table + 4);
+					std::int32_t high = s4(table + 8);
+					out.printf("{ // %d to %d\n", low, high);
+					for(std::int64_t key = low;key <= high;key++)
+					{
+						out.number(key, 24);
+						out.write(": ");
+						out.number(static_cast<long>(pc) + s4(table + 12 + 4 * (key - low)));
+						out.write('\n');
+					}
+				}
+				else
+				{
+					std::int32_t pairs = s4(table + 4);
+					out.printf("{ // %d\n", pairs);
+					for(std::int32_t i = 0;i < pairs;i++)
+					{
+						out.number(s4(table + 8 + 8 * i), 24);
+						out.write(": ");
+						out.number(static_cast<long>(pc) + s4(table + 12 + 8 * i));
+						out.write('\n');
+					}
+				}
+				out.printf("%24s: %ld\n%10s}\n", "default", defaultTarget, "");
+			}
+			break;
+		case OPERAND_WIDE:
+			if(operands[0] == OP_iinc)
+				out.printf("%s %u, %d\n", mnemonic(operands[0]), u2(operands + 1), static_cast<std::int16_t>(u2(operands + 3)));
+			else
+				out.printf("%s %u\n", mnemonic(operands[0]), u2(operands + 1));
+			break;
+	}
+}
+
+void writeCode(LineWriter & out, ConstantNames & pool, const ByteView & attribute)
+{
+	const unsigned char * data = reinterpret_cast<const unsigned char *>(attribute.data());
+	std::size_t size = attribute.size();
+	if(size < 8)
+	{
+		out.write("    // truncated Code attribute\n");
+		return;
+	}
+	
+	std::size_t codeLength = (std::uint32_t(data[4]) << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+	codeLength = std::min(codeLength, size - 8);
+	out.printf("    Code:\n      stack=%u, locals=%u, code_length=%zu\n", u2(data), u2(data + 2), codeLength);
+	
+	const unsigned char * code = data + 8;
+	for(std::size_t pc = 0;pc < codeLength;)
+	{
+		std::size_t length = instructionLength(code, pc, codeLength);
+		if(length == 0)
+		{
+			out.printf("%8zu: %s, truncated\n", pc, mnemonic(code[pc]));
+			break;
+		}
+		writeInstruction(out, pool, code, pc, length);
+		pc += length;
+	}
+	
+	std::size_t pos = 8 + codeLength;
+	if(pos + 2 > size)
+		return;
+	std::uint16_t exceptions = u2(data + pos);
+	pos += 2;
+	if(exceptions > 0 && pos + 8 * exceptions <= size)
+	{
+		out.write("    Exception table:\n       from    to  target type\n");
+		for(std::uint16_t i = 0;i < exceptions;i++, pos += 8)
+		{
+			std::uint16_t catchType = u2(data + pos + 6);
+			out.printf("      %5u %5u %5u   ", u2(data + pos), u2(data + pos + 2), u2(data + pos + 4));
+			if(catchType == 0)
+				out.write("any\n");
+			else
+				writeConstantOperand(out, pool, catchType);
+		}
+	}
+	
+	if(pos + 2 > size)
+		return;
+	std::uint16_t attributes = u2(data + pos);
+	pos += 2;
+	for(std::uint16_t i = 0;i < attributes && pos + 6 <= size;i++)
+	{
+		std::string name = utf8(pool.constants(), u2(data + pos));
+		std::size_t length = s4(data + pos + 2) & 0xffffffffu;
+		pos += 6;
+		if(length > size - pos)
+			break;
+		
+		if(name == "LineNumberTable" && length >= 2)
+		{
+			out.write("    LineNumberTable:\n");
+			std::uint16_t lines = u2(data + pos);
+			for(std::uint16_t j = 0;j < lines && 2 + 4 * (std::size_t(j) + 1) <= length;j++)
+				out.printf("      line %u: %u\n", u2(data + pos + 4 + 4 * j), u2(data + pos + 2 + 4 * j));
+		}
+		else
+		{
+			out.printf("    %s: %zu bytes\n", name.c_str(), length);
+		}
+		pos += length;
+	}
+}
+
+void writeFlags(LineWriter & out, bool isPublic, bool isProtected, bool isPrivate, bool isStatic, bool isFinal)
+{
+	if(isPublic)
+		out.write("public ");
+	if(isProtected)
+		out.write("protected ");
+	if(isPrivate)
+		out.write("private ");
+	if(isStatic)
+		out.write("static ");
+	if(isFinal)
+		out.write("final ");
+}
+
+}
+
+void disassembleClass(const ClassOutput & output, std::ostream & file)
+{
+	STATS_TIMER(STAGE_EMIT);
+	LineWriter out(file);
+	ConstantNames pool(*output.pool);
+	
+	if(output.isPublic)
+		out.write("public ");
+	if(output.isAbstract && !output.isInterface)
+		out.write("abstract ");
+	if(output.isFinal)
+		out.write("final ");
+	out.write(output.isInterface ? "interface " : output.isEnum ? "enum " : "class ");
+	out.write(output.name);
+	if(output.extends != "Object")
+	{
+		out.write(" extends ");
+		out.write(output.extends);
+	}
+	for(std::size_t i = 0;i < output.interfaces.size();i++)
+	{
+		out.write(i ? ", " : " implements ");
+		out.write(output.interfaces[i]);
+	}
+	out.write(" {\n");
+	
+	for(std::size_t f = 0;f < output.fields.size();f++)
+	{
+		const FieldOutput field = output.field(f);
+		out.write("  ");
+		writeFlags(out, field.isPublic(), field.isProtected(), field.isPrivate(), field.isStatic(), field.isFinal());
+		if(field.isVolatile())
+			out.write("volatile ");
+		if(field.isTransient())
+			out.write("transient ");
+		out.write(field.type + " " + field.name + ";\n\n");
+	}
+	
+	for(std::size_t m = 0;m < output.methods.size();m++)
+	{
+		const MethodOutput method = output.method(m);
+		out.write("  ");
+		writeFlags(out, method.isPublic(), method.isProtected(), method.isPrivate(), method.isStatic(), method.isFinal());
+		if(method.isSynchronized())
+			out.write("synchronized ");
+		if(method.isNative())
+			out.write("native ");
+		if(method.isAbstract())
+			out.write("abstract ");
+		if(method.name == "<clinit>")
+		{
+			out.write("{}");
+		}
+		else
+		{
+			if(method.name == "<init>")
+				out.write(output.name);
+			else
+				out.write(method.returnType + " " + method.name);
+			out.write("(");
+			for(std::size_t i = 0;i < method.parametersType.size();i++)
+			{
+				if(i)
+					out.write(", ");
+				out.write(method.parametersType[i]);
+			}
+			out.write(")");
+		}
+		out.write(";\n");
+		
+		for(const auto & attribute : method.attributes)
+		{
+			if(std::get<0>(attribute) == "Code")
+				writeCode(out, pool, std::get<1>(attribute));
+			else
+				out.printf("    %s: %zu bytes\n", std::get<0>(attribute).c_str(), std::get<1>(attribute).size());
+		}
+		out.write("\n");
+	}
+	out.write("}\n");
+}
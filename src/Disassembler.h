@@ -0,0 +1,37 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <ostream>
+
+#include "ClassOutput.h"
+
+// javap -c like listing of a parsed class: every instruction with its pc,
+// mnemonic and operands resolved through the constant pool, then the
+// exception table and the line numbers of each method
+void disassembleClass(const ClassOutput & output, std::ostream & file);
+
+#endif
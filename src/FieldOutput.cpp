@@ -23,25 +23,25 @@ freely, subject to the following restrictions:
    distribution.
 */
 #include "FieldOutput.h"
-#include <fstream>
+#include <ostream>
 
 #define W(c) file << c
 
-void FieldOutput::generate(std::ofstream & file)
+void FieldOutput::generate(std::ostream & file)
 {
-	if(isPublic)
+	if(isPublic())
 		W("public ");
-	if(isProtected)
+	if(isProtected())
 		W("protected ");
-	if(isPrivate)
+	if(isPrivate())
 		W("private ");
-	if(isStatic)
+	if(isStatic())
 		W("static ");
-	if(isFinal)
+	if(isFinal())
 		W("final ");
-	if(isTransient)
+	if(isTransient())
 		W("transient ");
-	if(isVolatile)
+	if(isVolatile())
 		W("volatile ");
 	
 	W(type);
@@ -25,6 +25,10 @@ freely, subject to the following restrictions:
 #ifndef FIELDOUTPUT_H
 #define FIELDOUTPUT_H
 
+#include "ByteView.h"
+#include "defines.h"
+#include <cstdint>
+#include <ostream>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -32,18 +36,20 @@ freely, subject to the following restrictions:
 class FieldOutput
 {
 public:
-	void generate(std::ofstream & file);
+	void generate(std::ostream & file);
 	
 	std::string name;
 	std::string type;
-	std::vector<std::tuple<std::string, std::string>> attributes;
-	bool isPublic = false,
-		 isProtected = false,
-		 isPrivate = false,
-		 isVolatile = false,
-		 isFinal = false,
-		 isStatic = false,
-		 isTransient = false;
+	// the data points into the class file buffer
+	std::vector<std::tuple<std::string, ByteView>> attributes;
+	std::uint16_t accessFlags = 0; // ACC_ bits, see defines.h
+	bool isPublic() const { return (accessFlags & ACC_PUBLIC) != 0; }
+	bool isProtected() const { return (accessFlags & ACC_PROTECTED) != 0; }
+	bool isPrivate() const { return (accessFlags & ACC_PRIVATE) != 0; }
+	bool isVolatile() const { return (accessFlags & ACC_VOLATILE) != 0; }
+	bool isFinal() const { return (accessFlags & ACC_FINAL) != 0; }
+	bool isStatic() const { return (accessFlags & ACC_STATIC) != 0; }
+	bool isTransient() const { return (accessFlags & ACC_TRANSIENT) != 0; }
 };
 
 #endif
@@ -0,0 +1,123 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "FileUtils.h"
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <dirent.h>
+#include <sys/stat.h>
+
+bool makeDirectories(const std::string & path)
+{
+	std::size_t pos = 0;
+	do
+	{
+		pos = path.find('/', pos + 1);
+		std::string sub = path.substr(0, pos);
+		if(mkdir(sub.c_str(), 0755) != 0 && errno != EEXIST)
+			return false;
+	} while(pos != std::string::npos);
+	
+	return true;
+}
+
+bool readFile(const std::string & path, std::vector<std::uint8_t> & data)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if(!file.is_open())
+		return false;
+	
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return !file.bad();
+}
+
+bool writeFile(const std::string & path, const std::string & text)
+{
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!file.is_open())
+		return false;
+	
+	file.write(text.data(), text.size());
+	return file.good();
+}
+
+bool isDirectory(const std::string & path)
+{
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool endsWith(const std::string & str, const std::string & suffix)
+{
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool isSafeRelativePath(const std::string & path)
+{
+	if(path.empty() || path[0] == '/' || path.find('\\') != std::string::npos || path.find('\0') != std::string::npos)
+		return false;
+	
+	for(std::size_t start = 0;start <= path.size();)
+	{
+		std::size_t end = path.find('/', start);
+		if(end == std::string::npos)
+			end = path.size();
+		if(path.compare(start, end - start, "..") == 0)
+			return false;
+		start = end + 1;
+	}
+	return true;
+}
+
+static void listFiles(const std::string & root, const std::string & prefix, std::vector<std::string> & files)
+{
+	DIR * dir = opendir((root + "/" + prefix).c_str());
+	if(!dir)
+		return;
+	
+	struct dirent * entry;
+	while((entry = readdir(dir)) != nullptr)
+	{
+		std::string name = entry->d_name;
+		if(name == "." || name == "..")
+			continue;
+		
+		std::string relative = prefix.empty() ? name : prefix + "/" + name;
+		if(isDirectory(root + "/" + relative))
+			listFiles(root, relative, files);
+		else
+			files.push_back(relative);
+	}
+	closedir(dir);
+}
+
+std::vector<std::string> listFiles(const std::string & directory)
+{
+	std::vector<std::string> files;
+	listFiles(directory, std::string(), files);
+	std::sort(files.begin(), files.end());
+	return files;
+}
@@ -0,0 +1,43 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef FILEUTILS_H
+#define FILEUTILS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+bool makeDirectories(const std::string & path);
+bool readFile(const std::string & path, std::vector<std::uint8_t> & data);
+bool writeFile(const std::string & path, const std::string & text);
+bool isDirectory(const std::string & path);
+bool endsWith(const std::string & str, const std::string & suffix);
+// false for a path which could land outside the directory it is appended
+// to: empty, absolute, with a .. component, a backslash or a nul byte
+bool isSafeRelativePath(const std::string & path);
+// every regular file under directory, sorted, relative to it
+std::vector<std::string> listFiles(const std::string & directory);
+
+#endif
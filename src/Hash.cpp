@@ -0,0 +1,143 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Hash.h"
+#include <cstring>
+
+static const std::uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const std::uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const std::uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const std::uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const std::uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline std::uint64_t rotl(std::uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+// the format is defined as little endian, as are all the hosts we build on
+static inline std::uint64_t read64(const std::uint8_t * p)
+{
+	std::uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline std::uint32_t read32(const std::uint8_t * p)
+{
+	std::uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline std::uint64_t xxRound(std::uint64_t acc, std::uint64_t input)
+{
+	acc += input * PRIME64_2;
+	acc = rotl(acc, 31);
+	return acc * PRIME64_1;
+}
+
+static inline std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t val)
+{
+	acc ^= xxRound(0, val);
+	return acc * PRIME64_1 + PRIME64_4;
+}
+
+std::uint64_t xxhash64(const void * data, std::size_t length, std::uint64_t seed)
+{
+	const std::uint8_t * p = static_cast<const std::uint8_t *>(data);
+	const std::uint8_t * end = p + length;
+	std::uint64_t h;
+	
+	if(length >= 32)
+	{
+		const std::uint8_t * limit = end - 32;
+		std::uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+		std::uint64_t v2 = seed + PRIME64_2;
+		std::uint64_t v3 = seed;
+		std::uint64_t v4 = seed - PRIME64_1;
+		
+		do
+		{
+			v1 = xxRound(v1, read64(p));
+			v2 = xxRound(v2, read64(p + 8));
+			v3 = xxRound(v3, read64(p + 16));
+			v4 = xxRound(v4, read64(p + 24));
+			p += 32;
+		} while(p <= limit);
+		
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = mergeRound(h, v1);
+		h = mergeRound(h, v2);
+		h = mergeRound(h, v3);
+		h = mergeRound(h, v4);
+	}
+	else
+	{
+		h = seed + PRIME64_5;
+	}
+	
+	h += static_cast<std::uint64_t>(length);
+	
+	while(p + 8 <= end)
+	{
+		h ^= xxRound(0, read64(p));
+		h = rotl(h, 27) * PRIME64_1 + PRIME64_4;
+		p += 8;
+	}
+	
+	if(p + 4 <= end)
+	{
+		h ^= static_cast<std::uint64_t>(read32(p)) * PRIME64_1;
+		h = rotl(h, 23) * PRIME64_2 + PRIME64_3;
+		p += 4;
+	}
+	
+	while(p < end)
+	{
+		h ^= (*p) * PRIME64_5;
+		h = rotl(h, 11) * PRIME64_1;
+		p++;
+	}
+	
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	
+	return h;
+}
+
+std::string toHex(std::uint64_t value)
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string ret(16, '0');
+	for(int i = 15;i >= 0;i--)
+	{
+		ret[i] = digits[value & 0xf];
+		value >>= 4;
+	}
+	return ret;
+}
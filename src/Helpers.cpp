@@ -24,14 +24,15 @@ freely, subject to the following restrictions:
 */
 #include "Helpers.h"
 #include "defines.h"
-#include <iostream>
+#include "Diagnostics.h"
+#include "OpcodeInfo.h"
+#include <cstdio>
+#include <cstring>
 #include <algorithm>
 
 using namespace std;
 
-std::vector<CPinfo> constant_pool;
-
-char letterFromType(std::string type)
+char letterFromType(const std::string & type)
 {
 	if(type == "int")
 		return 'i';
@@ -80,14 +81,16 @@ std::string typeFromInt(int typeInt)
 	return ret;
 }
 
-std::string getName(std::uint16_t index)
+std::string getName(const ConstantPool & constant_pool, std::uint16_t index)
 {
 	std::string ret_string("*ERROR*");
 	
-	CPinfo *data = &constant_pool[index];
-	if(data->tag == CONSTANT_Utf8)
+	if(index >= constant_pool.size())
+		return ret_string;
+	
+	if(constant_pool.tag(index) == CONSTANT_Utf8)
 	{
-		ret_string = std::string(data->UTF8Info.bytes);
+		ret_string.assign(constant_pool.utf8(index), constant_pool.utf8Length(index));
 	}
 	
 	return ret_string;
@@ -115,40 +118,19 @@ std::string removeArray(std::string className)
 	return className;
 }
 
-std::vector<std::string> parseSignature(std::string signature)
+std::vector<std::string> parseSignature(const std::string & signature)
 {
 	std::vector<std::string> params;
+	params.reserve(4);
 	
 	int i = 0;
-	if(signature[i] == '(')
+	int size = static_cast<int>(signature.size());
+	if(size > 0 && signature[i] == '(')
 	{
 		i++;
-		
-		int next_is_array = 0;
-		std::string type;
-		while(signature[i] != ')')
+		while(i < size && signature[i] != ')')
 		{
-			if(signature[i] == '[')
-			{
-				next_is_array++;
-			}
-			else
-			{
-				type = parseType(signature, i);
-			}
-			
-			if(type.length() > 0)
-			{
-				std::string tmp = type;
-				while(next_is_array > 0)
-				{
-					tmp += "[]";
-					next_is_array--;
-				}
-				params.push_back(tmp);
-				tmp.clear();
-			}
-			
+			params.push_back(parseType(signature, i)); // arrays included
 			i++;
 		}
 		i++; // skip the ')'
@@ -159,8 +141,14 @@ std::vector<std::string> parseSignature(std::string signature)
 	return params;
 }
 
-std::string parseType(std::string signature, int & i)
+std::string parseType(const std::string & signature, int & i)
 {
+	if(i >= static_cast<int>(signature.size()))
+	{
+		DIAG(DIAG_ERROR, "descriptor " << signature << " is truncated");
+		return "?";
+	}
+	
 	std::string tmp;
 	switch(signature[i])
 	{
@@ -183,12 +171,17 @@ std::string parseType(std::string signature, int & i)
 			tmp = "long";
 			break;
 		case 'L':
-			do
 			{
-				i++;
-				tmp += signature[i];
-			} while(signature[i] != ';');
-			tmp.pop_back();
+				std::size_t end = signature.find(';', i);
+				if(end == std::string::npos)
+				{
+					DIAG(DIAG_ERROR, "descriptor " << signature << " is truncated");
+					i = static_cast<int>(signature.size()) - 1;
+					return "?";
+				}
+				tmp.assign(signature, i + 1, end - i - 1);
+				i = static_cast<int>(end);
+			}
 			break;
 		case 'S':
 			tmp = "short";
@@ -205,11 +198,188 @@ std::string parseType(std::string signature, int & i)
 			tmp = "void";
 			break;
 		default:
-			cerr << "unrecognized parameter '" << signature[i] << "' type in signature" << endl;
-			exit(1);
+			// the class is still written, with the type left unknown
+			DIAG(DIAG_ERROR, "unrecognized type '" << signature[i] << "' in descriptor " << signature);
+			return "?";
+	}
+	
+	return checkClassName(std::move(tmp));
+}
+
+// moves i past the field type starting there; false if there is none
+static bool skipFieldType(const char * descriptor, std::size_t length, std::size_t & i)
+{
+	while(i < length && descriptor[i] == '[')
+		i++;
+	if(i >= length)
+		return false;
+	
+	switch(descriptor[i])
+	{
+		case 'B':
+		case 'C':
+		case 'D':
+		case 'F':
+		case 'I':
+		case 'J':
+		case 'S':
+		case 'Z':
+			i++;
+			return true;
+		case 'L':
+			{
+				const void * end = std::memchr(descriptor + i, ';', length - i);
+				if(!end || end == descriptor + i + 1)
+					return false;
+				i = static_cast<const char *>(end) - descriptor + 1;
+			}
+			return true;
+	}
+	return false;
+}
+
+bool isValidDescriptor(const char * descriptor, std::size_t length, bool method)
+{
+	std::size_t i = 0;
+	if(method)
+	{
+		if(length == 0 || descriptor[0] != '(')
+			return false;
+		for(i = 1;i < length && descriptor[i] != ')';)
+		{
+			if(!skipFieldType(descriptor, length, i))
+				return false;
+		}
+		if(i++ >= length)
+			return false;
+		if(i + 1 == length && descriptor[i] == 'V')
+			return true;
+	}
+	return skipFieldType(descriptor, length, i) && i == length;
+}
+
+std::int32_t readInt(const unsigned char * p)
+{
+	return static_cast<std::int32_t>(p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]);
+}
+
+std::string opcodeName(unsigned char opcode)
+{
+	if(opcodeInfo(opcode).mnemonic)
+		return opcodeInfo(opcode).mnemonic;
+	
+	char name[8];
+	std::snprintf(name, sizeof(name), "0x%02x", opcode);
+	return name;
+}
+
+// returns 0 if the instruction doesn't fit in the code
+std::size_t instructionLength(const unsigned char * code, std::size_t pc, std::size_t codeLength)
+{
+	std::size_t length = opcodeInfo(code[pc]).length;
+	if(length == 0)
+	{
+		if(code[pc] == OP_wide)
+		{
+			length = (pc + 1 < codeLength && code[pc + 1] == OP_iinc) ? 6 : 4;
+		}
+		else
+		{
+			// switches are aligned on 4 bytes from the start of the code
+			std::size_t base = pc + 1 + (4 - (pc + 1) % 4) % 4;
+			if(base + 12 > codeLength)
+				return 0;
+			
+			if(code[pc] == OP_tableswitch)
+			{
+				std::int64_t low = readInt(code + base + 4);
+				std::int64_t high = readInt(code + base + 8);
+				if(high < low)
+					return 0;
+				length = base - pc + 12 + 4 * (high - low + 1);
+			}
+			else
+			{
+				std::int64_t npairs = readInt(code + base + 4);
+				if(npairs < 0)
+					return 0;
+				length = base - pc + 8 + 8 * npairs;
+			}
+		}
 	}
 	
-	tmp = checkClassName(tmp);
+	if(pc + length > codeLength)
+		return 0;
+	
+	return length;
+}
+
+static bool isRef(std::uint8_t tag)
+{
+	return tag == CONSTANT_Fieldref || tag == CONSTANT_Methodref || tag == CONSTANT_InterfaceMethodref;
+}
+
+static bool isUtf8(std::uint8_t tag)
+{
+	return tag == CONSTANT_Utf8;
+}
+
+static bool isClass(std::uint8_t tag)
+{
+	return tag == CONSTANT_Class;
+}
+
+static bool isNameAndType(std::uint8_t tag)
+{
+	return tag == CONSTANT_NameAndType;
+}
+
+// resolveConstant() of an index which must be a constant of the given kind;
+// each step goes one level down (MethodHandle, Ref, Class or NameAndType,
+// Utf8), so even a malformed pool pointing back at itself ends there
+static std::string resolveExpected(const ConstantPool & constant_pool, std::uint16_t index, bool (*expected)(std::uint8_t))
+{
+	if(index == 0 || index >= constant_pool.size() || !expected(constant_pool.tag(index)))
+		return "?";
+	return resolveConstant(constant_pool, index);
+}
+
+// textual value of a constant, independent of the layout of the pool
+std::string resolveConstant(const ConstantPool & constant_pool, std::uint16_t index)
+{
+	if(index == 0 || index >= constant_pool.size())
+		return "?";
+	
+	const CPinfo & info = constant_pool[index];
+	switch(constant_pool.tag(index))
+	{
+		case CONSTANT_Utf8:
+			return getName(constant_pool, index);
+		case CONSTANT_Integer:
+			return "I" + std::to_string(info.IntegerInfo.bytes);
+		case CONSTANT_Float:
+			return "F" + std::to_string(info.FloatInfo.bytes);
+		case CONSTANT_Long:
+			return "J" + std::to_string(info.BigIntInfo.bytes);
+		case CONSTANT_Double:
+			return "D" + std::to_string(info.DoubleInfo.bytes);
+		case CONSTANT_Class:
+			return "C" + resolveExpected(constant_pool, info.ClassInfo.name_index, isUtf8);
+		case CONSTANT_String:
+			return "S" + resolveExpected(constant_pool, info.StringInfo.string_index, isUtf8);
+		case CONSTANT_Fieldref:
+		case CONSTANT_Methodref:
+		case CONSTANT_InterfaceMethodref:
+			return "R" + resolveExpected(constant_pool, info.RefInfo.class_index, isClass) + "." + resolveExpected(constant_pool, info.RefInfo.name_and_type_index, isNameAndType);
+		case CONSTANT_NameAndType:
+			return resolveExpected(constant_pool, info.NameAndTypeInfo.name_index, isUtf8) + ":" + resolveExpected(constant_pool, info.NameAndTypeInfo.descriptor_index, isUtf8);
+		case CONSTANT_MethodHandle:
+			return "H" + std::to_string(info.MethodHandleInfo.reference_kind) + resolveExpected(constant_pool, info.MethodHandleInfo.reference_index, isRef);
+		case CONSTANT_MethodType:
+			return "T" + resolveExpected(constant_pool, info.MethodTypeInfo.descriptor_index, isUtf8);
+		case CONSTANT_InvokeDynamic:
+			return "Y" + std::to_string(info.InvokeDynamicInfo.bootstrap_method_attr_index) + resolveExpected(constant_pool, info.InvokeDynamicInfo.name_and_type_index, isNameAndType);
+	}
 	
-	return tmp;
+	return "?";
 }
@@ -29,14 +29,22 @@ freely, subject to the following restrictions:
 #include <vector>
 #include "CPinfo.h"
 
-char letterFromType(std::string type);
+char letterFromType(const std::string & type);
 std::string typeFromInt(int typeInt);
-std::string getName(std::uint16_t index);
+std::string getName(const ConstantPool & constant_pool, std::uint16_t index);
 std::string removeArray(std::string className);
 std::string checkClassName(std::string classname);	
-std::vector<std::string> parseSignature(std::string signature);
-std::string parseType(std::string signature, int & i);
-
-extern std::vector<CPinfo> constant_pool;
+// the Java types of the parameters, then of the return type; a type which
+// can't be read is reported as a diagnostic and written "?"
+std::vector<std::string> parseSignature(const std::string & signature);
+std::string parseType(const std::string & signature, int & i);
+// checks a field descriptor, or a method one
+bool isValidDescriptor(const char * descriptor, std::size_t length, bool method);
+// mnemonic, or the hexadecimal value of an undefined opcode
+std::string opcodeName(unsigned char opcode);
+// big-endian, as in the class file
+std::int32_t readInt(const unsigned char * p);
+std::size_t instructionLength(const unsigned char * code, std::size_t pc, std::size_t codeLength);
+std::string resolveConstant(const ConstantPool & constant_pool, std::uint16_t index);
 
 #endif
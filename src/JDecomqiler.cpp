@@ -0,0 +1,209 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "JDecomqiler.h"
+#include "Cache.h"
+#include "ClassFile.h"
+#include "Stats.h"
+#include <cstring>
+#include <streambuf>
+
+namespace {
+
+// std::streambuf forwarding to an OutputSink, so the generators can keep
+// writing to a std::ostream
+class SinkBuffer : public std::streambuf
+{
+public:
+	SinkBuffer(OutputSink & sink)
+		: sink(sink)
+	{
+		setp(buffer, buffer + sizeof(buffer));
+	}
+	
+	~SinkBuffer()
+	{
+		sync();
+	}
+
+protected:
+	int_type overflow(int_type c) override
+	{
+		sync();
+		if(c != traits_type::eof())
+		{
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+	
+	std::streamsize xsputn(const char * s, std::streamsize n) override
+	{
+		if(n > epptr() - pptr())
+		{
+			sync();
+			if(n > epptr() - pptr())
+			{
+				sink.write(s, n);
+				return n;
+			}
+		}
+		std::memcpy(pptr(), s, n);
+		pbump(static_cast<int>(n));
+		return n;
+	}
+	
+	int sync() override
+	{
+		if(pptr() > pbase())
+		{
+			sink.write(pbase(), pptr() - pbase());
+			setp(buffer, buffer + sizeof(buffer));
+		}
+		return 0;
+	}
+
+private:
+	OutputSink & sink;
+	char buffer[4096];
+};
+
+DecompileStatus generate(const std::uint8_t * data, std::size_t length, const DecompileOptions & options, OutputSink & sink)
+{
+	ClassFile cf(data, length);
+	if(!cf.isValid())
+		return DECOMPILE_INVALID_CLASS;
+	
+	return writeClass(cf, options, sink) ? DECOMPILE_PARTIAL : DECOMPILE_OK;
+}
+
+}
+
+static const char * formatNames[] = {"java", "disasm", "json", "ast"};
+static const char * formatExtensions[] = {".java", ".javap", ".json", ".ast"};
+
+const char * outputExtension(OutputFormat format)
+{
+	return formatExtensions[format];
+}
+
+bool parseOutputFormat(const std::string & name, OutputFormat & format)
+{
+	for(std::size_t i = 0;i < sizeof(formatNames) / sizeof(formatNames[0]);i++)
+	{
+		if(name == formatNames[i])
+		{
+			format = static_cast<OutputFormat>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+unsigned writeClass(ClassFile & cf, const DecompileOptions & options, OutputSink & sink)
+{
+	SinkBuffer buffer(sink);
+	std::ostream file(&buffer);
+	unsigned stubs = 0;
+	switch(options.format)
+	{
+		case FORMAT_DISASM:
+			cf.disassemble(file);
+			break;
+		case FORMAT_JSON:
+		case FORMAT_AST:
+			cf.setBudgets(options.methodBudget, options.classBudget);
+			stubs = cf.writeModel(file, options.format == FORMAT_AST ? MODEL_BINARY : MODEL_JSON);
+			break;
+		default:
+			cf.setBudgets(options.methodBudget, options.classBudget);
+			stubs = cf.generate(file, options.methodMemo);
+	}
+	file.flush();
+	return stubs;
+}
+
+StreamSink::StreamSink(std::ostream & stream)
+	: stream(stream)
+{
+}
+
+void StreamSink::write(const char * data, std::size_t length)
+{
+	stream.write(data, length);
+}
+
+void StringSink::write(const char * data, std::size_t length)
+{
+	text.append(data, length);
+}
+
+std::string cacheKey(const std::uint8_t * data, std::size_t length, const DecompileOptions & options)
+{
+	// everything, besides the class itself, that changes the generated text
+	std::string salt = "jdecomqiler " JDECOMQILER_VERSION;
+	if(options.format != FORMAT_JAVA)
+		salt += std::string(" format ") + outputExtension(options.format);
+	
+	return DecompileCache::makeKey(data, length, salt);
+}
+
+static DecompileStatus cachedGenerate(const std::uint8_t * data, std::size_t length, const DecompileOptions & options, OutputSink & sink)
+{
+	if(!options.cache || !options.cache->isOpen())
+		return generate(data, length, options, sink);
+	
+	std::string key = cacheKey(data, length, options);
+	StringSink output;
+	if(options.cache->lookup(key, output.text))
+	{
+		sink.write(output.text.data(), output.text.size());
+		return DECOMPILE_OK;
+	}
+	
+	DecompileStatus status = generate(data, length, options, output);
+	// partial output is not stored, the next run may have the time to finish
+	if(status == DECOMPILE_OK)
+		options.cache->store(key, output.text);
+	if(status != DECOMPILE_INVALID_CLASS)
+		sink.write(output.text.data(), output.text.size());
+	return status;
+}
+
+DecompileStatus decompile(const std::uint8_t * data, std::size_t length, const DecompileOptions & options, OutputSink & sink)
+{
+	// the caller may already be collecting the statistics of this class
+	if(!statsEnabled() || currentClassStats)
+		return cachedGenerate(data, length, options, sink);
+	
+	ClassStats stats;
+	DecompileStatus status;
+	{
+		STATS_SCOPE(&stats);
+		status = cachedGenerate(data, length, options, sink);
+	}
+	addClassStats(stats);
+	return status;
+}
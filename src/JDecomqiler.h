@@ -0,0 +1,107 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef JDECOMQILER_H
+#define JDECOMQILER_H
+
+#include "Budget.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+class DecompileCache;
+class MethodMemo;
+
+#define JDECOMQILER_VERSION "0.2.0"
+
+// receives the generated text, possibly in several chunks
+class OutputSink
+{
+public:
+	virtual ~OutputSink() {}
+	virtual void write(const char * data, std::size_t length) = 0;
+};
+
+class StreamSink : public OutputSink
+{
+public:
+	StreamSink(std::ostream & stream);
+	void write(const char * data, std::size_t length) override;
+
+private:
+	std::ostream & stream;
+};
+
+class StringSink : public OutputSink
+{
+public:
+	void write(const char * data, std::size_t length) override;
+
+	std::string text;
+};
+
+enum OutputFormat
+{
+	FORMAT_JAVA = 0,
+	FORMAT_DISASM, // javap -c like listing, see Disassembler.h
+	FORMAT_JSON, // the decompiled model, see ModelWriter.h
+	FORMAT_AST // the same in binary
+};
+
+// ".java" and so on
+const char * outputExtension(OutputFormat format);
+// "java", "disasm", "json" or "ast"; returns false for an unknown name
+bool parseOutputFormat(const std::string & name, OutputFormat & format);
+
+struct DecompileOptions
+{
+	OutputFormat format = FORMAT_JAVA;
+	DecompileCache * cache = nullptr; // reuse the output of identical classes
+	MethodMemo * methodMemo = nullptr; // reuse the output of identical methods
+	Budget methodBudget; // methods going over are replaced by stubs (not in disasm)
+	Budget classBudget; // once spent, the remaining methods are stubs
+};
+
+enum DecompileStatus
+{
+	DECOMPILE_OK = 0,
+	DECOMPILE_INVALID_CLASS,
+	DECOMPILE_PARTIAL // some methods ran out of budget, see COUNTER_STUBBED_METHODS
+};
+
+class ClassFile;
+
+// writes the parsed class in options.format, a method at a time for Java;
+// returns the number of methods replaced by stubs
+unsigned writeClass(ClassFile & cf, const DecompileOptions & options, OutputSink & sink);
+
+// decompiles the class file held in [data, data + length)
+// the buffer only needs to stay alive for the duration of the call
+DecompileStatus decompile(const std::uint8_t * data, std::size_t length, const DecompileOptions & options, OutputSink & sink);
+
+// key of the class in options.cache
+std::string cacheKey(const std::uint8_t * data, std::size_t length, const DecompileOptions & options);
+
+#endif
@@ -0,0 +1,245 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "JarReader.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define SIG_LOCAL_HEADER   0x04034b50
+#define SIG_CENTRAL_HEADER 0x02014b50
+#define SIG_END            0x06054b50
+#define SIG_END64          0x06064b50
+#define SIG_END64_LOCATOR  0x07064b50
+
+#define METHOD_STORED   0
+#define METHOD_DEFLATED 8
+
+#define MAX_ENTRY_SIZE (1ULL << 30) // no class file comes close, but zip bombs do
+
+static std::uint16_t le16(const unsigned char * p)
+{
+	return static_cast<std::uint16_t>(p[0] | p[1] << 8);
+}
+
+static std::uint32_t le32(const unsigned char * p)
+{
+	return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 | static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+static std::uint64_t le64(const unsigned char * p)
+{
+	return static_cast<std::uint64_t>(le32(p)) | static_cast<std::uint64_t>(le32(p + 4)) << 32;
+}
+
+JarReader::JarReader(const std::string & path)
+{
+	fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return;
+	
+	if(!findCentralDirectory())
+	{
+		close(fd);
+		fd = -1;
+	}
+}
+
+JarReader::~JarReader()
+{
+	if(fd >= 0)
+		close(fd);
+}
+
+bool JarReader::isOpen() const
+{
+	return fd >= 0;
+}
+
+bool JarReader::readAt(std::uint64_t offset, void * buffer, std::size_t length)
+{
+	char * out = static_cast<char *>(buffer);
+	while(length > 0)
+	{
+		ssize_t n = pread(fd, out, length, offset);
+		if(n <= 0)
+			return false;
+		out += n;
+		offset += n;
+		length -= n;
+	}
+	return true;
+}
+
+bool JarReader::findCentralDirectory()
+{
+	struct stat st;
+	if(fstat(fd, &st) != 0)
+		return false;
+	fileSize = st.st_size;
+	if(fileSize < 22)
+		return false;
+	
+	// the end record is followed by a comment of at most 64KB
+	std::size_t tail = static_cast<std::size_t>(std::min<std::uint64_t>(fileSize, 22 + 0xffff));
+	std::vector<unsigned char> buffer(tail);
+	if(!readAt(fileSize - tail, buffer.data(), tail))
+		return false;
+	
+	for(std::size_t i = tail - 22 + 1;i-- > 0;)
+	{
+		const unsigned char * end = buffer.data() + i;
+		if(le32(end) != SIG_END)
+			continue;
+		
+		remaining = le16(end + 10);
+		position = le32(end + 16);
+		
+		// zip64: the real values are in another record, found through the locator
+		std::uint64_t endOffset = fileSize - tail + i;
+		unsigned char locator[20];
+		if(endOffset >= 20 && readAt(endOffset - 20, locator, 20) && le32(locator) == SIG_END64_LOCATOR)
+		{
+			unsigned char end64[56];
+			if(!readAt(le64(locator + 8), end64, 56) || le32(end64) != SIG_END64)
+				return false;
+			remaining = le64(end64 + 32);
+			position = le64(end64 + 48);
+		}
+		
+		return position < fileSize;
+	}
+	
+	return false;
+}
+
+bool JarReader::nextEntry(Entry & entry)
+{
+	if(fd < 0 || remaining == 0)
+		return false;
+	
+	unsigned char header[46];
+	if(!readAt(position, header, 46) || le32(header) != SIG_CENTRAL_HEADER)
+	{
+		remaining = 0;
+		return false;
+	}
+	
+	std::uint16_t nameLength = le16(header + 28);
+	std::uint16_t extraLength = le16(header + 30);
+	std::uint16_t commentLength = le16(header + 32);
+	
+	std::vector<unsigned char> variable(nameLength + extraLength);
+	if(!readAt(position + 46, variable.data(), variable.size()))
+	{
+		remaining = 0;
+		return false;
+	}
+	
+	entry.name.assign(reinterpret_cast<char *>(variable.data()), nameLength);
+	entry.method = le16(header + 10);
+	entry.compressedSize = le32(header + 20);
+	entry.size = le32(header + 24);
+	entry.offset = le32(header + 42);
+	
+	// zip64 extended information, only present for the fields that overflowed
+	const unsigned char * extra = variable.data() + nameLength;
+	const unsigned char * extraEnd = extra + extraLength;
+	while(extra + 4 <= extraEnd)
+	{
+		std::uint16_t id = le16(extra);
+		std::uint16_t size = le16(extra + 2);
+		const unsigned char * field = extra + 4;
+		const unsigned char * fieldEnd = std::min(field + size, extraEnd);
+		extra = field + size;
+		if(id == 0x0001)
+		{
+			if(entry.size == 0xffffffff && field + 8 <= fieldEnd)
+			{
+				entry.size = le64(field);
+				field += 8;
+			}
+			if(entry.compressedSize == 0xffffffff && field + 8 <= fieldEnd)
+			{
+				entry.compressedSize = le64(field);
+				field += 8;
+			}
+			if(entry.offset == 0xffffffff && field + 8 <= fieldEnd)
+			{
+				entry.offset = le64(field);
+			}
+		}
+	}
+	
+	position += 46 + nameLength + extraLength + commentLength;
+	remaining--;
+	return true;
+}
+
+bool JarReader::read(const Entry & entry, std::vector<std::uint8_t> & data)
+{
+	if(fd < 0 || entry.size > MAX_ENTRY_SIZE || entry.compressedSize > MAX_ENTRY_SIZE)
+		return false;
+	
+	unsigned char header[30];
+	if(!readAt(entry.offset, header, 30) || le32(header) != SIG_LOCAL_HEADER)
+		return false;
+	
+	std::uint64_t start = entry.offset + 30 + le16(header + 26) + le16(header + 28);
+	if(start + entry.compressedSize > fileSize)
+		return false;
+	
+	if(entry.method == METHOD_STORED)
+	{
+		data.resize(entry.size);
+		return entry.size == entry.compressedSize && readAt(start, data.data(), data.size());
+	}
+	
+	if(entry.method != METHOD_DEFLATED)
+		return false;
+	
+	std::vector<unsigned char> compressed(entry.compressedSize);
+	if(!readAt(start, compressed.data(), compressed.size()))
+		return false;
+	
+	data.resize(entry.size);
+	
+	z_stream stream;
+	std::memset(&stream, 0, sizeof(stream));
+	if(inflateInit2(&stream, -MAX_WBITS) != Z_OK) // raw deflate, no zlib header
+		return false;
+	
+	stream.next_in = compressed.data();
+	stream.avail_in = static_cast<uInt>(compressed.size());
+	stream.next_out = data.data();
+	stream.avail_out = static_cast<uInt>(data.size());
+	int ret = inflate(&stream, Z_FINISH);
+	bool ok = (ret == Z_STREAM_END || (ret == Z_BUF_ERROR && entry.size == 0)) && stream.total_out == entry.size;
+	inflateEnd(&stream);
+	
+	return ok;
+}
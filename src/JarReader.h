@@ -0,0 +1,65 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef JARREADER_H
+#define JARREADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// walks the central directory of a jar (zip, zip64 included) one entry at
+// a time, so the memory used doesn't depend on the number of entries
+class JarReader
+{
+public:
+	struct Entry
+	{
+		std::string name;
+		std::uint16_t method;
+		std::uint64_t compressedSize;
+		std::uint64_t size;
+		std::uint64_t offset; // of the local header
+	};
+	
+	JarReader(const std::string & path);
+	JarReader(const JarReader &) = delete;
+	JarReader & operator=(const JarReader &) = delete;
+	~JarReader();
+	
+	bool isOpen() const;
+	bool nextEntry(Entry & entry);
+	bool read(const Entry & entry, std::vector<std::uint8_t> & data);
+
+private:
+	bool readAt(std::uint64_t offset, void * buffer, std::size_t length);
+	bool findCentralDirectory();
+	
+	int fd = -1;
+	std::uint64_t fileSize = 0;
+	std::uint64_t position = 0; // next central directory header
+	std::uint64_t remaining = 0; // entries left to read
+};
+
+#endif
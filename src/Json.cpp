@@ -0,0 +1,220 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Json.h"
+#include <sstream>
+
+namespace {
+
+// how each byte is written in a string: 0 as it is, 'u' as \u00XX, else
+// the letter after the backslash; the long source texts of the batch
+// records go through this one lookup per byte
+struct JsonEscapes
+{
+	char letters[256] = {};
+	
+	JsonEscapes()
+	{
+		for(int c = 0;c < 0x20;c++)
+			letters[c] = 'u';
+		letters['\b'] = 'b';
+		letters['\f'] = 'f';
+		letters['\n'] = 'n';
+		letters['\r'] = 'r';
+		letters['\t'] = 't';
+		letters['"'] = '"';
+		letters['\\'] = '\\';
+	}
+};
+
+const JsonEscapes jsonEscapes;
+
+}
+
+std::string jsonString(const std::string & str)
+{
+	std::ostringstream out;
+	writeJsonString(out, str);
+	return out.str();
+}
+
+void writeJsonString(std::ostream & out, const std::string & str)
+{
+	writeJsonString(out, str.data(), str.size());
+}
+
+void writeJsonString(std::ostream & out, const char * str, std::size_t length)
+{
+	static const char hex[] = "0123456789abcdef";
+	
+	out << '"';
+	std::size_t run = 0; // start of the characters written as they are
+	for(std::size_t i = 0;i < length;i++)
+	{
+		unsigned char c = str[i];
+		char escape = jsonEscapes.letters[c];
+		if(!escape)
+			continue;
+		
+		out.write(str + run, i - run);
+		run = i + 1;
+		if(escape == 'u')
+		{
+			const char code[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+			out.write(code, sizeof(code));
+		}
+		else
+		{
+			const char code[] = {'\\', escape};
+			out.write(code, sizeof(code));
+		}
+	}
+	out.write(str + run, length - run);
+	out << '"';
+}
+
+static void skipSpaces(const std::string & line, std::size_t & i)
+{
+	while(i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r' || line[i] == '\n'))
+		i++;
+}
+
+static bool parseString(const std::string & line, std::size_t & i, std::string & value)
+{
+	if(i >= line.size() || line[i] != '"')
+		return false;
+	
+	value.clear();
+	for(i++;i < line.size();i++)
+	{
+		char c = line[i];
+		if(c == '"')
+		{
+			i++;
+			return true;
+		}
+		if(c != '\\')
+		{
+			value += c;
+			continue;
+		}
+		
+		if(++i >= line.size())
+			return false;
+		switch(line[i])
+		{
+			case 'n': value += '\n'; break;
+			case 'r': value += '\r'; break;
+			case 't': value += '\t'; break;
+			case 'b': value += '\b'; break;
+			case 'f': value += '\f'; break;
+			case 'u':
+				{
+					if(i + 4 >= line.size())
+						return false;
+					unsigned int code = 0;
+					for(std::size_t end = i + 4;i < end;)
+					{
+						char digit = line[++i];
+						code <<= 4;
+						if(digit >= '0' && digit <= '9')
+							code |= digit - '0';
+						else if(digit >= 'a' && digit <= 'f')
+							code |= digit - 'a' + 10;
+						else if(digit >= 'A' && digit <= 'F')
+							code |= digit - 'A' + 10;
+						else
+							return false;
+					}
+					// only what writeJsonString() produces, control characters
+					if(code < 0x80)
+					{
+						value += static_cast<char>(code);
+					}
+					else if(code < 0x800)
+					{
+						value += static_cast<char>(0xc0 | (code >> 6));
+						value += static_cast<char>(0x80 | (code & 0x3f));
+					}
+					else
+					{
+						value += static_cast<char>(0xe0 | (code >> 12));
+						value += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+						value += static_cast<char>(0x80 | (code & 0x3f));
+					}
+				}
+				break;
+			default: value += line[i];
+		}
+	}
+	return false;
+}
+
+bool parseJsonObject(const std::string & line, std::map<std::string, std::string> & fields)
+{
+	std::size_t i = 0;
+	skipSpaces(line, i);
+	if(i >= line.size() || line[i++] != '{')
+		return false;
+	
+	skipSpaces(line, i);
+	if(i < line.size() && line[i] == '}')
+		return true;
+	
+	while(i < line.size())
+	{
+		std::string key, value;
+		skipSpaces(line, i);
+		if(!parseString(line, i, key))
+			return false;
+		skipSpaces(line, i);
+		if(i >= line.size() || line[i++] != ':')
+			return false;
+		skipSpaces(line, i);
+		
+		if(i < line.size() && line[i] == '"')
+		{
+			if(!parseString(line, i, value))
+				return false;
+		}
+		else
+		{
+			// numbers, true, false, null: kept as they are written
+			std::size_t start = i;
+			while(i < line.size() && line[i] != ',' && line[i] != '}' && line[i] != ' ')
+				i++;
+			value = line.substr(start, i - start);
+		}
+		fields[key] = value;
+		
+		skipSpaces(line, i);
+		if(i >= line.size())
+			return false;
+		if(line[i] == '}')
+			return true;
+		if(line[i++] != ',')
+			return false;
+	}
+	return false;
+}
@@ -0,0 +1,40 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+
+// just what is needed to write and read back our own records: escaped
+// strings, and flat objects with string or number values
+std::string jsonString(const std::string & str);
+void writeJsonString(std::ostream & out, const std::string & str);
+void writeJsonString(std::ostream & out, const char * str, std::size_t length);
+bool parseJsonObject(const std::string & line, std::map<std::string, std::string> & fields);
+
+#endif
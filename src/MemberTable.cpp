@@ -0,0 +1,62 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "MemberTable.h"
+
+void MemberTable::reserve(std::size_t members)
+{
+	accessFlags.reserve(members);
+	nameIndex.reserve(members);
+	descriptorIndex.reserve(members);
+	firstAttribute.reserve(members);
+	attributes.reserve(members); // about one per member, Code or ConstantValue
+}
+
+void MemberTable::add(std::uint16_t flags, std::uint16_t name, std::uint16_t descriptor)
+{
+	accessFlags.push_back(flags);
+	nameIndex.push_back(name);
+	descriptorIndex.push_back(descriptor);
+	firstAttribute.push_back(static_cast<std::uint32_t>(attributes.size()));
+}
+
+void MemberTable::addAttribute(std::uint16_t name, ByteView data)
+{
+	attributes.push_back(Attribute{name, data});
+}
+
+std::size_t MemberTable::size() const
+{
+	return accessFlags.size();
+}
+
+std::size_t MemberTable::attributeBegin(std::size_t i) const
+{
+	return firstAttribute[i];
+}
+
+std::size_t MemberTable::attributeEnd(std::size_t i) const
+{
+	return i + 1 < firstAttribute.size() ? firstAttribute[i + 1] : attributes.size();
+}
@@ -0,0 +1,62 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef MEMBERTABLE_H
+#define MEMBERTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ByteView.h"
+
+// the methods or the fields of a class as parsed, one array per column:
+// scanning the flags of thousands of members reads a few cache lines, and
+// no string is built until ClassOutput::method() or field() asks for one
+class MemberTable
+{
+public:
+	struct Attribute
+	{
+		std::uint16_t nameIndex;
+		ByteView data; // into the class file buffer
+	};
+	
+	void reserve(std::size_t members);
+	// adds a member, its attributes follow
+	void add(std::uint16_t flags, std::uint16_t name, std::uint16_t descriptor);
+	void addAttribute(std::uint16_t name, ByteView data);
+	std::size_t size() const;
+	// the attributes of member i are [attributeBegin(i), attributeEnd(i))
+	std::size_t attributeBegin(std::size_t i) const;
+	std::size_t attributeEnd(std::size_t i) const;
+	
+	std::vector<std::uint16_t> accessFlags; // ACC_ bits, see defines.h
+	std::vector<std::uint16_t> nameIndex;
+	std::vector<std::uint16_t> descriptorIndex;
+	std::vector<std::uint32_t> firstAttribute;
+	std::vector<Attribute> attributes;
+};
+
+#endif
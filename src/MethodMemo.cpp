@@ -0,0 +1,78 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "MethodMemo.h"
+#include "Hash.h"
+
+std::size_t MethodMemo::KeyHash::operator()(const std::string & key) const
+{
+	return static_cast<std::size_t>(xxhash64(key.data(), key.size()));
+}
+
+MethodMemo::MethodMemo(std::size_t maxBytes)
+	: maxBytes(maxBytes), lookupCount(0), hitCount(0)
+{
+}
+
+bool MethodMemo::lookup(const std::string & key, Entry & entry)
+{
+	lookupCount++;
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = entries.find(key);
+	if(it == entries.end())
+		return false;
+	
+	entry = it->second;
+	hitCount++;
+	return true;
+}
+
+void MethodMemo::store(const std::string & key, const Entry & entry)
+{
+	std::size_t size = key.size() + entry.text.size() + entry.opcodes.size() * sizeof(entry.opcodes[0]);
+	if(size > maxBytes)
+		return;
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	if(bytes + size > maxBytes)
+	{
+		// start over rather than tracking the age of every entry
+		entries.clear();
+		bytes = 0;
+	}
+	
+	if(entries.emplace(key, entry).second)
+		bytes += size;
+}
+
+std::uint64_t MethodMemo::lookups() const
+{
+	return lookupCount;
+}
+
+std::uint64_t MethodMemo::hits() const
+{
+	return hitCount;
+}
@@ -0,0 +1,73 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef METHODMEMO_H
+#define METHODMEMO_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// in-memory table of already generated methods, shared by all the classes
+// decompiled in the process, see MethodOutput::memoKey()
+class MethodMemo
+{
+public:
+	struct Entry
+	{
+		std::string text; // see MethodOutput::memoText()
+		// what generating it cost, charged again on a hit
+		std::uint64_t instructions = 0;
+		std::uint64_t bytes = 0;
+		std::vector<std::pair<std::uint8_t, std::uint32_t>> opcodes; // decoded, and how many times, when the stats were on
+	};
+	
+	MethodMemo(std::size_t maxBytes = 64 << 20);
+	
+	bool lookup(const std::string & key, Entry & entry);
+	void store(const std::string & key, const Entry & entry);
+	
+	std::uint64_t lookups() const;
+	std::uint64_t hits() const;
+
+private:
+	struct KeyHash
+	{
+		std::size_t operator()(const std::string & key) const;
+	};
+	
+	std::unordered_map<std::string, Entry, KeyHash> entries;
+	std::size_t bytes = 0;
+	std::size_t maxBytes;
+	std::mutex mutex;
+	std::atomic<std::uint64_t> lookupCount;
+	std::atomic<std::uint64_t> hitCount;
+};
+
+#endif
@@ -23,12 +23,21 @@ freely, subject to the following restrictions:
    distribution.
 */
 #include "MethodOutput.h"
+#include "Diagnostics.h"
 #include "Helpers.h"
+#include "NumberFormat.h"
+#include "OpcodeInfo.h"
 #include "opcodes.h"
-#include <iostream>
-#include <fstream>
+#include "Stats.h"
+#include "StringLiteral.h"
+#include "Trace.h"
+#include <ostream>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
 
 using namespace std;
 
@@ -79,13 +88,26 @@ using namespace std;
 		BUFF(buffOutput); \
 	}
 
+// an instruction whose constant isn't valid: its operands are dropped, and
+// its value, when it has one, is the placeholder
+#define INVALID_MEMBER(hasValue) \
+	if(!invalidMember.empty()) \
+	{ \
+		jvm_stack.resize(jvm_stack.size() - std::max(pops, 0)); \
+		if(hasValue) \
+			jvm_stack.push_back(std::move(invalidMember)); \
+		else \
+			BUFF(invalidMember + "\n"); \
+		break; \
+	}
+
 #define IF_OPCODE(op) \
 	{ \
 		unsigned char b1 = ref[++zz]; \
 		unsigned char b2 = ref[++zz]; \
 		int idx = static_cast<signed short>((b1 << 8) + b2) + opcodePos; \
 		\
-		std::string value = jvm_stack.back(); \
+		std::string value = std::move(jvm_stack.back()); \
 		jvm_stack.pop_back(); \
 		\
 		if(idx > opcodePos) \
@@ -106,15 +128,15 @@ using namespace std;
 		unsigned char b2 = ref[++zz]; \
 		int idx = static_cast<signed short>((b1 << 8) + b2) + opcodePos; \
 		\
-		std::string x = jvm_stack.back(); \
+		std::string x = std::move(jvm_stack.back()); \
 		jvm_stack.pop_back(); \
-		std::string y = jvm_stack.back(); \
+		std::string y = std::move(jvm_stack.back()); \
 		jvm_stack.pop_back(); \
 		\
 		bool hasGoto = false; \
 		int idxGoto = 0; \
-		unsigned char gotoTarget = ref[idx - 3 + 8]; \
-		if(gotoTarget == 0xa7) \
+		/* the targets are checked by ClassFile::validCode() */ \
+		if(idx >= 3 && static_cast<unsigned char>(ref[idx - 3 + 8]) == OP_goto) \
 		{ \
 			hasGoto = true; \
 			unsigned char b1 = ref[idx - 2 + 8]; \
@@ -143,21 +165,374 @@ using namespace std;
 		} \
 	}
 
-void MethodOutput::generate(std::ofstream & file)
+#define LOAD_CONSTANT(index, opcode) \
+	{ \
+		std::string literal, type; \
+		if(constantLiteral(constant_pool, index, literal, type)) \
+		{ \
+			if(!type.empty()) \
+				varTypes[literal] = type; \
+			jvm_stack.push_back(std::move(literal)); \
+		} \
+		else \
+		{ \
+			DIAG_AT(DIAG_WARNING, opcodePos, opcode " of unsupported constant tag " << static_cast<int>(static_cast<std::size_t>(index) < constant_pool.size() ? constant_pool.tag(index) : 0)); \
+			jvm_stack.push_back("/* constant #" + std::to_string(index) + " */"); \
+		} \
+	}
+
+namespace {
+
+// longest expression built, budget or not: a few dup and iadd double it
+// at every step, the method is a stub once it would go over
+const std::uint64_t MAX_EXPRESSION_BYTES = 1 << 22;
+// longest bytecode listing written in a stub
+const std::size_t STUB_LISTING_INSTRUCTIONS = 256;
+
+// the Java expression of a loadable constant, and its type for the
+// reference ones (left empty for numbers); false for those generate()
+// doesn't handle: method handles and types, dynamic constants
+bool constantLiteral(const ConstantPool & constant_pool, std::size_t index, std::string & literal, std::string & type)
+{
+	if(index == 0 || index >= constant_pool.size())
+		return false;
+	
+	const CPinfo & info = constant_pool[index];
+	switch(constant_pool.tag(index))
+	{
+		case CONSTANT_Integer:
+			literal = javaIntLiteral(static_cast<std::int32_t>(info.IntegerInfo.bytes));
+			return true;
+		case CONSTANT_Float:
+			{
+				float value;
+				std::memcpy(&value, &info.FloatInfo.bytes, sizeof(value));
+				literal = javaFloatLiteral(value);
+			}
+			return true;
+		case CONSTANT_Long:
+			literal = javaLongLiteral(static_cast<std::int64_t>(info.BigIntInfo.bytes));
+			return true;
+		case CONSTANT_Double:
+			{
+				double value;
+				std::memcpy(&value, &info.DoubleInfo.bytes, sizeof(value));
+				literal = javaDoubleLiteral(value);
+			}
+			return true;
+		case CONSTANT_String:
+			{
+				std::uint16_t text = info.StringInfo.string_index;
+				if(text >= constant_pool.size() || constant_pool.tag(text) != CONSTANT_Utf8)
+					return false;
+				literal = javaStringLiteral(constant_pool.utf8(text), constant_pool.utf8Length(text));
+				type = "String";
+			}
+			return true;
+		case CONSTANT_Class:
+			{
+				// arrays are named by their descriptor
+				std::string name = getName(constant_pool, info.ClassInfo.name_index);
+				int pos = 0;
+				type = "Class";
+				literal = (name[0] == '[' ? parseType(name, pos) : checkClassName(std::move(name))) + ".class";
+			}
+			return true;
+	}
+	return false;
+}
+
+// the parameters of a method descriptor, split the way parseSignature does
+std::size_t parameterCount(const std::string & descriptor)
+{
+	std::size_t size = descriptor.size();
+	if(size == 0 || descriptor[0] != '(')
+		return 0;
+	
+	std::size_t count = 0;
+	for(std::size_t i = 1;i < size && descriptor[i] != ')';i++)
+	{
+		while(i < size && descriptor[i] == '[')
+			i++;
+		if(i < size && descriptor[i] == 'L')
+			i = std::min(descriptor.find(';', i), size - 1);
+		count++;
+	}
+	return count;
+}
+
+bool returnsVoid(const std::string & descriptor)
+{
+	std::size_t size = descriptor.size();
+	return size >= 2 && descriptor[size - 2] == ')' && descriptor[size - 1] == 'V';
+}
+
+// the text of the Utf8 constant index into text; false when it isn't one
+bool utf8Constant(const ConstantPool & constant_pool, std::uint16_t index, std::string & text)
+{
+	if(index == 0 || index >= constant_pool.size() || constant_pool.tag(index) != CONSTANT_Utf8)
+		return false;
+	text.assign(constant_pool.utf8(index), constant_pool.utf8Length(index));
+	return true;
+}
+
+// the name of the Class constant an instruction refers to; false when the
+// constant isn't one
+bool classConstant(const ConstantPool & constant_pool, std::uint16_t index, std::string & name)
+{
+	if(index == 0 || index >= constant_pool.size() || constant_pool.tag(index) != CONSTANT_Class)
+		return false;
+	return utf8Constant(constant_pool, constant_pool[index].ClassInfo.name_index, name);
+}
+
+// the class (none for invokedynamic), name and descriptor of the constant a
+// field access or an invoke refers to; false when it, or the constants it
+// points to, aren't of the kinds the opcode expects
+bool memberConstant(const ConstantPool & constant_pool, unsigned char opcode, std::uint16_t index, std::string & className, std::string & name, std::string & descriptor)
+{
+	if(index == 0 || index >= constant_pool.size())
+		return false;
+	
+	std::uint8_t tag = constant_pool.tag(index);
+	bool expected;
+	switch(opcode)
+	{
+		case OP_invokevirtual:
+			expected = tag == CONSTANT_Methodref;
+			break;
+		case OP_invokespecial:
+		case OP_invokestatic:
+			// interface methods too since Java 8
+			expected = tag == CONSTANT_Methodref || tag == CONSTANT_InterfaceMethodref;
+			break;
+		case OP_invokeinterface:
+			expected = tag == CONSTANT_InterfaceMethodref;
+			break;
+		case OP_invokedynamic:
+			expected = tag == CONSTANT_InvokeDynamic;
+			break;
+		default:
+			expected = tag == CONSTANT_Fieldref;
+	}
+	if(!expected)
+		return false;
+	if(tag != CONSTANT_InvokeDynamic && !classConstant(constant_pool, constant_pool[index].RefInfo.class_index, className))
+		return false;
+	
+	// the name and type is at the same place in the three kinds of ref
+	// and in InvokeDynamic
+	std::uint16_t nameAndType = constant_pool[index].RefInfo.name_and_type_index;
+	if(nameAndType >= constant_pool.size() || constant_pool.tag(nameAndType) != CONSTANT_NameAndType)
+		return false;
+	const CPinfo & info = constant_pool[nameAndType];
+	return utf8Constant(constant_pool, info.NameAndTypeInfo.name_index, name) && utf8Constant(constant_pool, info.NameAndTypeInfo.descriptor_index, descriptor);
+}
+
+// reports the constant of an instruction which isn't of the kind it
+// expects, and returns what is written in its place
+std::string invalidConstant(int pc, unsigned char opcode, std::uint16_t index)
+{
+	DIAG_AT(DIAG_ERROR, pc, opcodeName(opcode) << " of the invalid constant #" << index);
+	return "/* invalid constant #" + std::to_string(index) + " */";
+}
+
+// the values getstatic to invokedynamic pop, from the descriptor of the
+// member they refer to, and the category of the value they push;
+// STACK_VARIABLE for an invoke of an invalid constant. The object of a
+// constructor called after a new is not on the stack (see OP_new), it is
+// left out when pendingNew
+int memberPops(unsigned char opcode, bool valid, const std::string & name, const std::string & descriptor, bool pendingNew, std::uint8_t & category)
 {
-	bool isCtor = false;
+	// the type of a field, or what follows the parameters of a method
+	std::size_t type = descriptor.find(')');
+	type = type == std::string::npos ? 0 : type + 1;
+	category = type < descriptor.size() && (descriptor[type] == 'J' || descriptor[type] == 'D') ? 2 : 1;
 	
-	if(isPublic)
+	switch(opcode)
+	{
+		case OP_getstatic:
+			return 0;
+		case OP_putstatic:
+		case OP_getfield:
+			return 1;
+		case OP_putfield:
+			return 2;
+	}
+	if(!valid)
+		return STACK_VARIABLE;
+	int count = static_cast<int>(parameterCount(descriptor));
+	if(opcode == OP_invokestatic || opcode == OP_invokedynamic)
+		return count;
+	if(opcode == OP_invokespecial && pendingNew && name == "<init>")
+		return count;
+	return count + 1;
+}
+
+// the number of words (category 1 values) pop2 and the dup which depend on
+// the categories move, then the words they copy them below; false for the
+// other opcodes
+bool wordOperands(unsigned char opcode, int & words, int & under)
+{
+	switch(opcode)
+	{
+		case OP_pop2:
+		case OP_dup2:
+			words = 2;
+			under = 0;
+			return true;
+		case OP_dup_x2:
+			words = 1;
+			under = 2;
+			return true;
+		case OP_dup2_x1:
+			words = 2;
+			under = 1;
+			return true;
+		case OP_dup2_x2:
+			words = 2;
+			under = 2;
+			return true;
+	}
+	return false;
+}
+
+// the values of the stack making up its top words, then the values making
+// up the under words below them, a long or a double being a single value of
+// two words; the values missing from the stack are counted as one word each.
+// false when a long or a double would be cut in two
+bool splitWords(const std::vector<std::uint8_t> & categories, int words, int under, int & top, int & below)
+{
+	std::size_t i = categories.size();
+	int counted = 0;
+	for(top = 0;counted < words;top++)
+		counted += i > 0 ? categories[--i] : 1;
+	bool whole = counted == words;
+	counted = 0;
+	for(below = 0;counted < under;below++)
+		counted += i > 0 ? categories[--i] : 1;
+	return whole && counted == under;
+}
+
+// the length of the expressions an instruction popping pops values combines
+// into its own; all the stack, up to what an invoke can take, when that
+// depends on the operands
+std::uint64_t operandBytes(const std::vector<std::string> & stack, int pops)
+{
+	std::size_t count = std::min<std::size_t>(stack.size(), pops == STACK_VARIABLE ? 256 : std::max(pops, 0));
+	std::uint64_t bytes = 0;
+	for(std::size_t i = stack.size() - count;i < stack.size();i++)
+		bytes += stack[i].size();
+	return bytes;
+}
+
+// body of a method which ran out of budget: its bytecode and a throw
+void writeStub(std::ostream & file, const std::string & name, const unsigned char * code, std::size_t code_size, const char * reason)
+{
+	W("/* " << reason << " budget exceeded, bytecode:\n");
+	std::size_t pc = 0;
+	for(std::size_t listed = 0;pc < code_size && listed < STUB_LISTING_INSTRUCTIONS;listed++)
+	{
+		std::size_t length = instructionLength(code, pc, code_size);
+		if(length == 0)
+			break;
+		
+		char line[16];
+		W(pc << ": " << opcodeName(code[pc]));
+		for(std::size_t i = 1;i < length;i++)
+		{
+			std::snprintf(line, sizeof(line), " %02x", code[pc + i]);
+			W(line);
+		}
+		W("\n");
+		pc += length;
+	}
+	if(pc < code_size)
+		W("... " << code_size - pc << " more bytes\n");
+	W("*/\n");
+	// names in bytecode may hold quotes and backslashes
+	W("throw new UnsupportedOperationException(" << javaStringLiteral(name + " not decompiled: " + reason + " budget exceeded") << ");\n");
+}
+
+// in a memo key or text, followed by what it stands for; doubled when it
+// is in the text itself
+const char MEMO_MARK = '\x01';
+const char MEMO_CLASS = 'c'; // as in the constant pool, with slashes
+const char MEMO_JAVA_CLASS = 'j'; // after checkClassName()
+const char MEMO_PARENT = 'p';
+
+void appendMemoEscaped(std::string & out, const char * text, std::size_t length)
+{
+	for(std::size_t i = 0;i < length;i++)
+	{
+		if(text[i] == MEMO_MARK)
+			out += MEMO_MARK;
+		out += text[i];
+	}
+}
+
+bool isNameChar(char c)
+{
+	return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' || c == '.' || c == '/' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+// whether a class name at i of a generated text ends at end: the name
+// alone, a member access, or a variable named after the class
+bool memoNameEnds(const std::string & text, std::size_t end)
+{
+	while(text.compare(end, 4, "_arr") == 0)
+		end += 4;
+	while(end < text.size() && std::isdigit(static_cast<unsigned char>(text[end])))
+		end++;
+	return end == text.size() || text[end] == '.' || !isNameChar(text[end]);
+}
+
+// whether a name can only be left in the key as it is: it is found in what
+// the key holds otherwise, or the decoder writes words which could start
+// with it (keywords and variables are lower case)
+bool memoPinned(const std::string & key, const std::string & name)
+{
+	if(name.empty() || name == "String" || name == "Class" || name == "Unhandled")
+		return true;
+	if(std::none_of(name.begin(), name.end(), [](char c) { return std::isupper(static_cast<unsigned char>(c)) != 0; }))
+		return true;
+	return key.find(name) != std::string::npos;
+}
+
+bool namePrefixes(const std::string & a, const std::string & b)
+{
+	return a != b && (a.compare(0, b.size(), b) == 0 || b.compare(0, a.size(), a) == 0);
+}
+
+}
+
+bool constantLoadDecompiled(std::uint8_t tag)
+{
+	switch(tag)
+	{
+		case CONSTANT_Integer:
+		case CONSTANT_Float:
+		case CONSTANT_Long:
+		case CONSTANT_Double:
+		case CONSTANT_String:
+		case CONSTANT_Class:
+			return true;
+	}
+	return false;
+}
+
+bool MethodOutput::generate(std::ostream & file)
+{
+	if(isPublic())
 		W("public ");
-	if(isProtected)
+	if(isProtected())
 		W("protected ");
-	if(isPrivate)
+	if(isPrivate())
 		W("private ");
-	if(isAbstract)
+	if(isAbstract())
 		W("abstract ");
-	if(isStatic)
+	if(isStatic())
 		W("static ");
-	if(isFinal)
+	if(isFinal())
 		W("final ");
 	
 	if(name == "<clinit>")
@@ -166,10 +541,7 @@ void MethodOutput::generate(std::ofstream & file)
 	else
 	{
 		if(name == "<init>")
-		{
 			W(thisClass);
-			isCtor = true;
-		}
 		else
 		{
 			W(returnType);
@@ -178,7 +550,7 @@ void MethodOutput::generate(std::ofstream & file)
 			
 		}
 		W("(");
-		int pos = (isStatic ? 0 : 1);
+		int pos = (isStatic() ? 0 : 1);
 		for(std::string str : parametersType)
 		{
 			if(pos > 1)
@@ -193,16 +565,31 @@ void MethodOutput::generate(std::ofstream & file)
 	}
 	W("{\n");
 	
+	bool complete = generateBody(file);
+	W("}\n\n");
+	return complete;
+}
+
+bool MethodOutput::generateBody(std::ostream & file, StatementSink * sink)
+{
+	TRACE_SCOPE("method", name);
+	DIAG_CONTEXT(&thisClass, &name);
+	bool isCtor = name == "<init>";
+	bool complete = true;
+	const ConstantPool & constant_pool = *pool;
+	
 	for(std::size_t i = 0;i < attributes.size();i++)
 	{
-		std::tuple<std::string, std::string> a = attributes[i];
+		const std::tuple<std::string, ByteView> & a = attributes[i];
 		
 		if(std::get<0>(a) == "Code")
 		{
-			const std::string & ref = std::get<1>(a);
+			STATS_TIMER(STAGE_DECODE); // the control flow and emission timers below are excluded
+			const ByteView & ref = std::get<1>(a);
 			int zz = 0;
 			
 			std::vector<std::string> jvm_stack;
+			std::vector<std::uint8_t> categories; // of each value of jvm_stack, 2 for a long or a double
 			
 			W("/*\n");
 			
@@ -238,22 +625,107 @@ void MethodOutput::generate(std::ofstream & file)
 			
 			std::vector<std::string> retNames;
 			std::vector<std::string> tmpNames;
-			std::map<std::string, std::string> varTypes;
+			std::unordered_map<std::string, std::string> varTypes;
 			std::map<int, std::vector<std::string>> jumpTargets;
 			std::vector<std::string> bufferMethod;
+			std::vector<std::pair<int, std::size_t>> instructionStarts; // offset in the code, index in bufferMethod
 			std::map<int, std::pair<std::string, std::string>> objectVariables; // int = variable ID, string = type of the object, string = name of the variable
 			std::map<std::string, int> objectTypeCounter;
-			bool nextInvokeIsNew = false;
+			int pendingNews = 0; // objects created by new, waiting for their constructor
+			std::uint32_t * opcodeCounts = STATS_OPCODES();
+			std::uint64_t instructions = 0;
+			
+			bool limited = (budget && budget->isSet()) || classMeter;
+			BudgetMeter methodMeter(budget ? *budget : Budget());
+			std::size_t bytesCounted = 0; // statements of bufferMethod already spent
+			const char * exceeded = classMeter ? classMeter->exceeded() : nullptr;
 			
-			int end = code_size + 8;
-			for(int opcodePos = 0;zz < end;zz++)
+			const unsigned char * code = reinterpret_cast<const unsigned char *>(ref.data()) + 8;
+			std::size_t codeLength = std::min<std::size_t>(code_size, ref.size() - std::min<std::size_t>(ref.size(), 8));
+			int end = codeLength + 8;
+			instructionStarts.reserve(codeLength / 2); // most instructions are one to three bytes
+			bufferMethod.reserve(codeLength / 8);
+			jvm_stack.reserve(std::min<std::size_t>(stack, codeLength)); // max_stack may be anything
+			categories.reserve(jvm_stack.capacity());
+			// of the field access or the invoke, looked up once for the
+			// stack check and the handler; kept from one instruction to the
+			// next, so that their buffers are too
+			std::string memberClass, memberName, memberDescriptor;
+			std::string invalidMember; // its placeholder when the constant isn't valid
+			for(int opcodePos = 0;zz < end && !exceeded;zz++)
 			{
 				opcodePos = zz - 8;
-				bufferMethod.push_back("/*" + std::to_string(opcodePos) + "*/ ");
+				instructionStarts.push_back(std::make_pair(opcodePos, bufferMethod.size()));
 
 				bool isLastOpcode = zz + 1 >= end;
 				
 				unsigned char c = ref[zz];
+				const OpcodeInfo & info = opcodeInfo(c);
+				std::size_t length = instructionLength(code, opcodePos, codeLength);
+				if(length == 0)
+				{
+					DIAG_AT(DIAG_ERROR, opcodePos, opcodeName(c) << " is truncated");
+					break;
+				}
+				// the handlers below may read less, never more (but new which
+				// takes the dup after it)
+				int last = zz + static_cast<int>(length) - 1;
+				
+				int pops = info.pops;
+				std::uint8_t category = info.category;
+				int words, under;
+				int topValues = 0, belowValues = 0; // see splitWords()
+				if(c >= OP_getstatic && c <= OP_invokedynamic)
+				{
+					memberClass.clear();
+					invalidMember.clear();
+					std::uint16_t index = static_cast<std::uint16_t>(code[opcodePos + 1] << 8 | code[opcodePos + 2]);
+					if(!memberConstant(constant_pool, c, index, memberClass, memberName, memberDescriptor))
+						invalidMember = invalidConstant(opcodePos, c, index);
+					pops = memberPops(c, invalidMember.empty(), memberName, memberDescriptor, pendingNews > 0, category);
+				}
+				else if(c == OP_multianewarray)
+					pops = code[opcodePos + 3];
+				else if(wordOperands(c, words, under))
+				{
+					if(!splitWords(categories, words, under, topValues, belowValues))
+						DIAG_AT(DIAG_ERROR, opcodePos, opcodeName(c) << " cuts a long or a double in two");
+					pops = topValues + belowValues;
+				}
+				if(pops > 0 && jvm_stack.size() < static_cast<std::size_t>(pops))
+				{
+					DIAG_AT(DIAG_ERROR, opcodePos, opcodeName(c) << " pops " << pops << " values from a stack of " << jvm_stack.size());
+					categories.insert(categories.begin(), pops - jvm_stack.size(), 1);
+					jvm_stack.insert(jvm_stack.begin(), pops - jvm_stack.size(), "/* stack underflow */");
+				}
+				std::size_t stackBefore = jvm_stack.size();
+				
+				if(opcodeCounts)
+					opcodeCounts[c]++;
+				instructions++;
+				// checked before the instruction copies its operands into
+				// a longer expression
+				std::uint64_t bytes = operandBytes(jvm_stack, pops);
+				if(bytes > MAX_EXPRESSION_BYTES)
+				{
+					exceeded = "bytes";
+					break;
+				}
+				if(limited)
+				{
+					for(;bytesCounted < bufferMethod.size();bytesCounted++)
+						bytes += bufferMethod[bytesCounted].size();
+					exceeded = methodMeter.spend(1, bytes);
+					if(classMeter)
+					{
+						const char * classExceeded = classMeter->spend(1, bytes);
+						if(!exceeded)
+							exceeded = classExceeded;
+					}
+					if(exceeded)
+						break;
+				}
+				decodedBytes += bytes;
 				switch(c)
 				{
 					case OP_nop:
@@ -320,20 +792,8 @@ void MethodOutput::generate(std::ofstream & file)
 						break;
 					case OP_ldc:
 						{
-							int idx = ref[++zz];
-							switch(constant_pool[idx].tag)
-							{
-								case CONSTANT_String:
-									{
-										std::string str = "\""+getName(constant_pool[idx].StringInfo.string_index)+"\"";
-										varTypes[str] = "String";
-										jvm_stack.push_back(str);
-									}
-									break;
-								default:
-									cerr << "0x12: unrecognized tag " << std::hex << static_cast<int>(constant_pool[idx].tag) << endl;
-									exit(1);
-							}
+							unsigned char idx = ref[++zz];
+							LOAD_CONSTANT(idx, "ldc")
 						}
 						break;
 					case OP_ldc_w:
@@ -342,15 +802,7 @@ void MethodOutput::generate(std::ofstream & file)
 							unsigned char b1 = ref[++zz];
 							unsigned char b2 = ref[++zz];
 							int idx = ((b1 << 8) + b2);
-							switch(constant_pool[idx].tag)
-							{
-								case CONSTANT_String:
-									jvm_stack.push_back("\""+getName(constant_pool[idx].StringInfo.string_index)+"\"");
-									break;
-								default:
-									cerr << std::hex << static_cast<int>(c) << ": unrecognized tag " << static_cast<int>(constant_pool[idx].tag) << endl;
-									exit(1);
-							}
+							LOAD_CONSTANT(idx, "ldc_w/ldc2_w")
 						}
 						break;
 					case OP_iload:
@@ -432,7 +884,7 @@ void MethodOutput::generate(std::ofstream & file)
 						jvm_stack.push_back("d3");
 						break;
 					case OP_aload_0:
-						if(isStatic)
+						if(isStatic())
 							jvm_stack.push_back(objectVariables[0].second);
 						else
 							jvm_stack.push_back("this");
@@ -455,9 +907,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_caload:
 					case OP_saload:
 						{
-							std::string index = jvm_stack.back();
+							std::string index = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string arr = jvm_stack.back();
+							std::string arr = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(arr + "[" + index + "]");
 							std::string oneDimensionLess = varTypes[arr];
@@ -582,28 +1034,30 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_castore:
 					case OP_sastore:
 						{
-							std::string value = jvm_stack.back();
+							std::string value = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string index = jvm_stack.back();
+							std::string index = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string arr = jvm_stack.back();
+							std::string arr = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							BUFF(arr + "[" + index + "] = " + value + ";\n");
 						}
 						break;
 					case OP_pop:
-					case OP_pop2: // since we don't treat double as 2 values
 						jvm_stack.pop_back();
 						break;
+					case OP_pop2:
+						jvm_stack.resize(jvm_stack.size() - topValues);
+						categories.resize(categories.size() - topValues);
+						break;
 					case OP_dup:
-						if(!nextInvokeIsNew)
-							jvm_stack.push_back(jvm_stack.back());
+						jvm_stack.push_back(jvm_stack.back());
 						break;
 					case OP_dup_x1:
 						{
-							std::string value1 = jvm_stack.back();
+							std::string value1 = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string value2 = jvm_stack.back();
+							std::string value2 = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							
 							jvm_stack.push_back(value1);
@@ -612,73 +1066,23 @@ void MethodOutput::generate(std::ofstream & file)
 						}
 						break;
 					case OP_dup_x2:
-						{
-							std::string value1 = jvm_stack.back();
-							jvm_stack.pop_back();
-							std::string value2 = jvm_stack.back();
-							jvm_stack.pop_back();
-							std::string value3 = jvm_stack.back();
-							jvm_stack.pop_back();
-							
-							jvm_stack.push_back(value1);
-							jvm_stack.push_back(value3);
-							jvm_stack.push_back(value2);
-							jvm_stack.push_back(value1);
-						}
-						break;
 					case OP_dup2:
-						{
-							std::string value1 = jvm_stack.back();
-							jvm_stack.pop_back();
-							std::string value2 = jvm_stack.back();
-							jvm_stack.pop_back();
-							
-							jvm_stack.push_back(value2);
-							jvm_stack.push_back(value1);
-							jvm_stack.push_back(value2);
-							jvm_stack.push_back(value1);
-						}
-						break;
 					case OP_dup2_x1:
-						{
-							std::string value1 = jvm_stack.back();
-							jvm_stack.pop_back();
-							std::string value2 = jvm_stack.back();
-							jvm_stack.pop_back();
-							std::string value3 = jvm_stack.back();
-							jvm_stack.pop_back();
-							
-							jvm_stack.push_back(value2);
-							jvm_stack.push_back(value1);
-							jvm_stack.push_back(value3);
-							jvm_stack.push_back(value2);
-							jvm_stack.push_back(value1);
-						}
-						break;
 					case OP_dup2_x2:
 						{
-							std::string value1 = jvm_stack.back();
-							jvm_stack.pop_back();
-							std::string value2 = jvm_stack.back();
-							jvm_stack.pop_back();
-							std::string value3 = jvm_stack.back();
-							jvm_stack.pop_back();
-							std::string value4 = jvm_stack.back();
-							jvm_stack.pop_back();
-							
-							jvm_stack.push_back(value2);
-							jvm_stack.push_back(value1);
-							jvm_stack.push_back(value4);
-							jvm_stack.push_back(value3);
-							jvm_stack.push_back(value2);
-							jvm_stack.push_back(value1);
+							// a copy of the top values goes below the values under them
+							std::size_t at = jvm_stack.size() - topValues - belowValues;
+							std::vector<std::string> values(jvm_stack.end() - topValues, jvm_stack.end());
+							jvm_stack.insert(jvm_stack.begin() + at, values.begin(), values.end());
+							std::vector<std::uint8_t> valueCategories(categories.end() - topValues, categories.end());
+							categories.insert(categories.begin() + at, valueCategories.begin(), valueCategories.end());
 						}
 						break;
 					case OP_swap:
 						{
-							std::string first = jvm_stack.back();
+							std::string first = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string second = jvm_stack.back();
+							std::string second = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(first);
 							jvm_stack.push_back(second);
@@ -689,9 +1093,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_fadd:
 					case OP_dadd:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " + " + y);
 						}
@@ -701,9 +1105,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_fsub:
 					case OP_dsub:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " - " + y);
 						}
@@ -713,9 +1117,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_fmul:
 					case OP_dmul:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " * " + y);
 						}
@@ -725,9 +1129,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_fdiv:
 					case OP_ddiv:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " * " + y);
 						}
@@ -737,9 +1141,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_frem:
 					case OP_drem:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " % " + y);
 						}
@@ -749,7 +1153,7 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_fneg:
 					case OP_dneg:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("-" + x);
 						}
@@ -758,9 +1162,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_lshl:
 					case OP_iushr:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " << " + y);
 						}
@@ -768,18 +1172,18 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_ishr:
 					case OP_lshr:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " >> " + y);
 						}
 						break;
 					case OP_lushr:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " >>> " + y);
 						}
@@ -787,9 +1191,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_iand:
 					case OP_land:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " & " + y);
 						}
@@ -797,9 +1201,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_ior:
 					case OP_lor:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " | " + y);
 						}
@@ -807,9 +1211,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_ixor:
 					case OP_lxor:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " | " + y);
 						}
@@ -846,7 +1250,7 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_f2l:
 					case OP_d2l:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("(long)" + x);
 						}
@@ -855,7 +1259,7 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_l2f:
 					case OP_d2f:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("(float)" + x);
 						}
@@ -864,7 +1268,7 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_l2d:
 					case OP_f2d:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("(double)" + x);
 						}
@@ -873,28 +1277,28 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_f2i:
 					case OP_d2i:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("(int)" + x);
 						}
 						break;
 					case OP_i2b:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("(byte)" + x);
 						}
 						break;
 					case OP_i2c:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("(char)" + x);
 						}
 						break;
 					case OP_i2s:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("(short)" + x);
 						}
@@ -905,9 +1309,9 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_dcmpl:
 					case OP_dcmpg:
 						{
-							std::string x = jvm_stack.back();
+							std::string x = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
-							std::string y = jvm_stack.back();
+							std::string y = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(x + " - " + y);
 						}
@@ -971,54 +1375,15 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_ret:
 						{
 							unsigned char i = ref[++zz];
-							cout << "RET to addr of local addr " << i << endl;
+							DIAG_AT(DIAG_DEBUG, opcodePos, "ret to the address in local " << static_cast<int>(i));
 						}
 						break;
 					case OP_tableswitch:
-						{
-							// TODO
-							cerr << "tableswitch not implemented, segfault incoming." << endl;
-							int tableSwitchOpcodePosition = zz;
-							zz += ((zz+1) % 4); // padding
-							
-							// default jump
-							unsigned char d1 = ref[++zz];
-							unsigned char d2 = ref[++zz];
-							unsigned char d3 = ref[++zz];
-							unsigned char d4 = ref[++zz];
-							int defaultJump = static_cast<int>((d1 << 24) + (d2 << 16) + (d3 << 8) + d4);
-							
-							// low jump
-							unsigned char l1 = ref[++zz];
-							unsigned char l2 = ref[++zz];
-							unsigned char l3 = ref[++zz];
-							unsigned char l4 = ref[++zz];
-							int lowJump = static_cast<int>((l1 << 24) + (l2 << 16) + (l3 << 8) + l4);
-							
-							// high jump
-							unsigned char h1 = ref[++zz];
-							unsigned char h2 = ref[++zz];
-							unsigned char h3 = ref[++zz];
-							unsigned char h4 = ref[++zz];
-							int highJump = static_cast<int>((h1 << 24) + (h2 << 16) + (h3 << 8) + h4);
-							
-							// dunno where the 7 comes from.
-							cout << "tableswitch: " << jvm_stack.back() << " => " << (defaultJump + tableSwitchOpcodePosition + 7) << ", " << lowJump << ", " << highJump << endl;
-							
-							for(int i = lowJump;i <= highJump;i++)
-							{
-								unsigned char jumpTarget1 = ref[++zz];
-								unsigned char jumpTarget2 = ref[++zz];
-								unsigned char jumpTarget3 = ref[++zz];
-								unsigned char jumpTarget4 = ref[++zz];
-								int jumpTarget = static_cast<int>((jumpTarget1 << 24) + (jumpTarget2 << 16) + (jumpTarget3 << 8) + jumpTarget4);
-								cout << "jumpTarget " << i << " : " << (jumpTarget + tableSwitchOpcodePosition + 7) << endl;
-							}
-						}
-						break;
 					case OP_lookupswitch:
-						// TODO
-						cerr << "lookupswitch not implemented, segfault incoming." << endl;
+						// TODO: the cases are only skipped for now, by the length of
+						// the instruction
+						BUFF("// switch(" + jvm_stack.back() + ") not decompiled\n");
+						jvm_stack.pop_back();
 						break;
 					case OP_ireturn:
 					case OP_lreturn:
@@ -1042,50 +1407,31 @@ void MethodOutput::generate(std::ofstream & file)
 						}
 					case OP_getstatic:
 						{
-							unsigned char b1 = ref[++zz];
-							unsigned char b2 = ref[++zz];
-							int idx = ((b1 << 8) + b2);
-							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_index_info = constant_pool[info.RefInfo.class_index];
-							CPinfo name_and_type_index_info = constant_pool[info.RefInfo.name_and_type_index];
-							
-							std::vector<std::string> params = parseSignature(getName(name_and_type_index_info.NameAndTypeInfo.descriptor_index));
-							std::string retour = params.back();
-							params.pop_back();
+							zz += 2;
+							INVALID_MEMBER(true)
 							
 							std::string static_call;
-							std::string staticClassName = checkClassName(getName(class_index_info.ClassInfo.name_index));
+							std::string staticClassName = checkClassName(std::move(memberClass));
 							if(staticClassName != thisClass)
 							{
 								static_call += staticClassName + ".";
 							}
-							static_call += getName(name_and_type_index_info.NameAndTypeInfo.name_index);
-							jvm_stack.push_back(static_call);
+							static_call += memberName;
+							jvm_stack.push_back(std::move(static_call));
 						}
 						break;
 					case OP_putstatic:
 						{
-							unsigned char b1 = ref[++zz];
-							unsigned char b2 = ref[++zz];
-							int idx = ((b1 << 8) + b2);
+							zz += 2;
+							INVALID_MEMBER(false)
 							
-							CPinfo info = constant_pool[idx];
-							
-							CPinfo class_index_info = constant_pool[info.RefInfo.class_index];
-							CPinfo name_and_type_index_info = constant_pool[info.RefInfo.name_and_type_index];
-							
-							std::vector<std::string> params = parseSignature(getName(name_and_type_index_info.NameAndTypeInfo.descriptor_index));
-							std::string retour = params.back();
-							params.pop_back();
-							
-							std::string staticClassName = getName(class_index_info.ClassInfo.name_index);
+							std::string staticClassName = std::move(memberClass);
 							std::string tmp;
 							if(staticClassName != thisClass)
 							{
 								tmp += staticClassName + ".";
 							}
-							tmp += getName(name_and_type_index_info.NameAndTypeInfo.name_index) + " = " + jvm_stack[jvm_stack.size() - 1] + ";\n";
+							tmp += memberName + " = " + jvm_stack[jvm_stack.size() - 1] + ";\n";
 							
 							BUFF(tmp);
 							
@@ -1094,41 +1440,21 @@ void MethodOutput::generate(std::ofstream & file)
 						break;
 					case OP_getfield:
 						{
-							unsigned char b1 = ref[++zz];
-							unsigned char b2 = ref[++zz];
-							int idx = ((b1 << 8) + b2);
+							zz += 2;
+							INVALID_MEMBER(true)
 							
-							CPinfo info = constant_pool[idx];
-							
-							// CPinfo class_index_info = constant_pool[info.RefInfo.class_index];
-							CPinfo name_and_type_index_info = constant_pool[info.RefInfo.name_and_type_index];
-							
-							std::vector<std::string> params = parseSignature(getName(name_and_type_index_info.NameAndTypeInfo.descriptor_index));
-							std::string retour = params.back();
-							params.pop_back();
-							
-							std::string tmp = jvm_stack.back() + "." + getName(name_and_type_index_info.NameAndTypeInfo.name_index);
+							std::string tmp = jvm_stack.back() + "." + memberName;
 							
 							jvm_stack.pop_back();
-							jvm_stack.push_back(tmp);
+							jvm_stack.push_back(std::move(tmp));
 						}
 						break;
 					case OP_putfield:
 						{
-							unsigned char b1 = ref[++zz];
-							unsigned char b2 = ref[++zz];
-							int idx = ((b1 << 8) + b2);
-							
-							CPinfo info = constant_pool[idx];
-							
-							// CPinfo class_index_info = constant_pool[info.RefInfo.class_index];
-							CPinfo name_and_type_index_info = constant_pool[info.RefInfo.name_and_type_index];
+							zz += 2;
+							INVALID_MEMBER(false)
 							
-							std::vector<std::string> params = parseSignature(getName(name_and_type_index_info.NameAndTypeInfo.descriptor_index));
-							std::string retour = params.back();
-							params.pop_back();
-							
-							std::string func_call = checkClassName(jvm_stack[jvm_stack.size() - 2]) + "." + getName(name_and_type_index_info.NameAndTypeInfo.name_index) + " = " + jvm_stack[jvm_stack.size() - 1] + ";\n";
+							std::string func_call = checkClassName(jvm_stack[jvm_stack.size() - 2]) + "." + memberName + " = " + jvm_stack[jvm_stack.size() - 1] + ";\n";
 							
 							BUFF(func_call);
 							
@@ -1140,27 +1466,21 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_invokespecial:
 						{
 							// bool invokevirtual = (c == 0xb6);
-							unsigned char b1 = ref[++zz];
-							unsigned char b2 = ref[++zz];
-							int idx = ((b1 << 8) + b2);
-							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_index_info = constant_pool[info.RefInfo.class_index];
-							CPinfo name_and_type_index_info = constant_pool[info.RefInfo.name_and_type_index];
+							zz += 2;
+							INVALID_MEMBER(false)
 							
-							std::string cii_name = checkClassName(getName(class_index_info.ClassInfo.name_index));
-							std::string fun_name = getName(name_and_type_index_info.NameAndTypeInfo.name_index);
+							std::string cii_name = checkClassName(std::move(memberClass));
+							std::string fun_name = std::move(memberName);
 							
-							std::vector<std::string> parametres = parseSignature(getName(name_and_type_index_info.NameAndTypeInfo.descriptor_index));
-							std::string returnType = parametres.back();
-							parametres.pop_back(); // remove the return type
+							std::size_t parameters = parameterCount(memberDescriptor);
+							bool returnsValue = !returnsVoid(memberDescriptor);
 							
+							bool nextInvokeIsNew = pendingNews > 0 && fun_name == "<init>";
 							std::string fun_call;
 							std::string variable_name;
 							if(nextInvokeIsNew)
 							{
-								unsigned char nextOP = ref[zz+1];
-								int next = nextOP;
+								int next = zz + 1 < end ? static_cast<unsigned char>(ref[zz+1]) : OP_nop;
 								if(next != OP_pop)
 								{
 									if(!objectTypeCounter.count(cii_name))
@@ -1204,9 +1524,12 @@ void MethodOutput::generate(std::ofstream & file)
 										fun_name = cii_name;
 								}
 								
-								if(jvm_stack[jvm_stack.size() - parametres.size() - 1] != "this")
+								std::string & objectRef = jvm_stack[jvm_stack.size() - parameters - 1];
+								if(objectRef != "this")
 								{
-									fun_call += jvm_stack[jvm_stack.size() - parametres.size() - 1] + ".";
+									// moved, so that long call chains are built in place
+									fun_call = std::move(objectRef);
+									fun_call += ".";
 								}
 								else
 								{
@@ -1218,18 +1541,18 @@ void MethodOutput::generate(std::ofstream & file)
 							}
 							
 							fun_call += "(";
-							for(std::size_t pp = 0;pp < parametres.size();pp++)
+							for(std::size_t pp = 0;pp < parameters;pp++)
 							{
 								if(pp > 0)
 									fun_call += ", ";
 								
-								fun_call += jvm_stack[jvm_stack.size() - parametres.size() + pp];
+								fun_call += jvm_stack[jvm_stack.size() - parameters + pp];
 							}
 							
 							// remove the ObjectRef
 							if(!nextInvokeIsNew)
 								jvm_stack.pop_back();
-							for(std::size_t i = 0;i < parametres.size();i++)
+							for(std::size_t i = 0;i < parameters;i++)
 							{
 								jvm_stack.pop_back();
 							}
@@ -1237,14 +1560,16 @@ void MethodOutput::generate(std::ofstream & file)
 							
 							if(nextInvokeIsNew)
 							{
-								BUFF(fun_call + ";\n");
+								fun_call += ";\n";
+								BUFF(std::move(fun_call));
 								jvm_stack.push_back(variable_name);
+								pendingNews--;
 							}
 							else
 							{
-								if(returnType != "void")
+								if(returnsValue)
 								{
-									jvm_stack.push_back(fun_call);
+									jvm_stack.push_back(std::move(fun_call));
 									/* probaly need to have this kind of code
 									unsigned char nextOP = ref[zz+1];
 									int next = nextOP;
@@ -1256,66 +1581,57 @@ void MethodOutput::generate(std::ofstream & file)
 								}
 								else
 								{
-									BUFF(fun_call + ";\n");
+									fun_call += ";\n";
+									BUFF(std::move(fun_call));
 								}
 							}
 						}
 						break;
 					case OP_invokestatic:
 						{
-							unsigned char b1 = ref[++zz];
-							unsigned char b2 = ref[++zz];
-							int idx = ((b1 << 8) + b2);
-							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_index_info = constant_pool[info.RefInfo.class_index];
-							CPinfo name_and_type_index_info = constant_pool[info.RefInfo.name_and_type_index];
+							zz += 2;
+							INVALID_MEMBER(false)
 							
-							std::string cii_name = checkClassName(getName(class_index_info.ClassInfo.name_index));
-							std::string fun_name = getName(name_and_type_index_info.NameAndTypeInfo.name_index);
+							std::string cii_name = checkClassName(std::move(memberClass));
+							std::string fun_name = std::move(memberName);
 							
-							std::vector<std::string> parametres = parseSignature(getName(name_and_type_index_info.NameAndTypeInfo.descriptor_index));
-							parametres.pop_back(); // remove the return type
+							std::size_t parameters = parameterCount(memberDescriptor);
 							
-							std::string fun_call = cii_name + "." + fun_name;
+							std::string fun_call = std::move(cii_name);
+							fun_call += '.';
+							fun_call += fun_name;
 							fun_call += "(";
-							for(std::size_t pp = 0;pp < parametres.size();pp++)
+							for(std::size_t pp = 0;pp < parameters;pp++)
 							{
 								if(pp > 0)
 									fun_call += ", ";
 								
-								fun_call += jvm_stack[jvm_stack.size() - parametres.size() + pp];
+								fun_call += jvm_stack[jvm_stack.size() - parameters + pp];
 							}
 							
-							for(std::size_t i = 0;i < parametres.size();i++)
+							for(std::size_t i = 0;i < parameters;i++)
 							{
 								jvm_stack.pop_back();
 							}
 							fun_call += ");\n";
 							
-							BUFF(fun_call);
+							BUFF(std::move(fun_call));
 						}
 						break;
 					case OP_invokeinterface:
 						{
-							unsigned char b1 = ref[++zz];
-							unsigned char b2 = ref[++zz];
-							int idx = ((b1 << 8) + b2);
+							zz += 2;
 							++zz; // int count = ref[++zz]; // unused
 							++zz; // int zero = ref[++zz]; // unused
+							INVALID_MEMBER(false)
 							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_index_info = constant_pool[info.RefInfo.class_index];
-							CPinfo name_and_type_index_info = constant_pool[info.RefInfo.name_and_type_index];
-							
-							std::string cii_name = checkClassName(getName(class_index_info.ClassInfo.name_index));
-							std::string fun_name = getName(name_and_type_index_info.NameAndTypeInfo.name_index);
+							std::string cii_name = checkClassName(std::move(memberClass));
+							std::string fun_name = std::move(memberName);
 							
-							std::vector<std::string> parametres = parseSignature(getName(name_and_type_index_info.NameAndTypeInfo.descriptor_index));
-							std::string returnType = parametres.back();
-							parametres.pop_back(); // remove the return type
+							std::size_t parameters = parameterCount(memberDescriptor);
+							bool returnsValue = !returnsVoid(memberDescriptor);
 							
-							std::string objectCalledUpon = jvm_stack[jvm_stack.size() - parametres.size() - 1];
+							std::string objectCalledUpon = jvm_stack[jvm_stack.size() - parameters - 1];
 							bool isNewCalled = false;
 							
 							if(fun_name == "<init>")
@@ -1350,22 +1666,22 @@ void MethodOutput::generate(std::ofstream & file)
 							
 							fun_call += fun_name;
 							fun_call += "(";
-							for(std::size_t pp = 0;pp < parametres.size();pp++)
+							for(std::size_t pp = 0;pp < parameters;pp++)
 							{
 								if(pp > 0)
 									fun_call += ", ";
 								
-								fun_call += jvm_stack[jvm_stack.size() - parametres.size() + pp];
+								fun_call += jvm_stack[jvm_stack.size() - parameters + pp];
 							}
 							
 							// <= to remove also the ObjectRef
-							for(std::size_t i = 0;i <= parametres.size();i++)
+							for(std::size_t i = 0;i <= parameters;i++)
 							{
 								jvm_stack.pop_back();
 							}
 							fun_call += ")";
 							
-							if(returnType != "void")
+							if(returnsValue)
 							{
 								// std::string retName = "ret" + returnType;
 								// std::string retNameAndOrType = retName;
@@ -1378,103 +1694,48 @@ void MethodOutput::generate(std::ofstream & file)
 								// }
 								// fun_call = retNameAndOrType + " = " + fun_call;
 								// jvm_stack.push_back(retName);
-								jvm_stack.push_back(fun_call);
+								jvm_stack.push_back(std::move(fun_call));
 							}
 							else
 							{
-								BUFF(fun_call + ";\n");
+								fun_call += ";\n";
+								BUFF(std::move(fun_call));
 							}
 						}
 						break;
-					case OP_invokedynamic: // (check if can be a new)
+					case OP_invokedynamic:
 						{
-							unsigned char b1 = ref[++zz];
-							unsigned char b2 = ref[++zz];
-							int idx = ((b1 << 8) + b2);
-							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_index_info = constant_pool[info.RefInfo.class_index];
-							CPinfo name_and_type_index_info = constant_pool[info.RefInfo.name_and_type_index];
-							
-							std::string cii_name = checkClassName(getName(class_index_info.ClassInfo.name_index));
-							std::string fun_name = getName(name_and_type_index_info.NameAndTypeInfo.name_index);
-							
-							std::vector<std::string> parametres = parseSignature(getName(name_and_type_index_info.NameAndTypeInfo.descriptor_index));
-							std::string returnType = parametres.back();
-							parametres.pop_back(); // remove the return type
+							// the call site has no receiver, only the
+							// arguments of its descriptor
+							INVALID_MEMBER(false)
 							
-							std::string objectCalledUpon = jvm_stack[jvm_stack.size() - parametres.size() - 1];
+							std::size_t parameters = parameterCount(memberDescriptor);
+							bool returnsValue = !returnsVoid(memberDescriptor);
 							
-							bool isNewCalled = false;
-							bool isInit = false;
-							
-							if(fun_name == "<init>")
-							{
-								if(isCtor && objectCalledUpon == "this")
-								{
-									// change this = new ParentClass() to this.super()
-									fun_name = "super";
-								}
-								else
-								{
-									isNewCalled = true;
-									fun_name = cii_name;
-								}
-								
-								isInit = true;
-							}
-							
-							std::string fun_call;
-							if(!isInit)
-								fun_call += "((" + varTypes[objectCalledUpon] + ")";
-							fun_call += objectCalledUpon;
-							if(!isInit)
-								fun_call += ")";
-							
-							if(isNewCalled)
-							{
-								fun_call += " = new ";
-							}
-							else
-							{
-								fun_call += ".";
-							}
-							
-							fun_call += fun_name;
+							std::string fun_call = std::move(memberName);
 							fun_call += "(";
-							for(std::size_t pp = 0;pp < parametres.size();pp++)
+							for(std::size_t pp = 0;pp < parameters;pp++)
 							{
 								if(pp > 0)
 									fun_call += ", ";
 								
-								fun_call += jvm_stack[jvm_stack.size() - parametres.size() + pp];
+								fun_call += jvm_stack[jvm_stack.size() - parameters + pp];
 							}
 							
-							// <= to remove also the ObjectRef
-							for(std::size_t i = 0;i <= parametres.size();i++)
+							for(std::size_t i = 0;i < parameters;i++)
 							{
 								jvm_stack.pop_back();
 							}
 							fun_call += ")";
 							
-							if(returnType != "void")
+							if(returnsValue)
 							{
-								// std::string retName = "ret" + returnType;
-								// std::string retNameAndOrType = retName;
-								// if(std::find(retNames.begin(), retNames.end(), returnType) == retNames.end())
-								// {
-									// varTypes[retName] = returnType;
-									// retNames.push_back(returnType);
-									
-									// retNameAndOrType = returnType + " " + retName;
-								// }
-								// fun_call = retNameAndOrType + " = " + fun_call;
-								// jvm_stack.push_back(retName);
-								jvm_stack.push_back(fun_call);
+								jvm_stack.push_back(std::move(fun_call));
 							}
 							else
 							{
-								BUFF(fun_call + ";\n");
+								fun_call += ";\n";
+								BUFF(std::move(fun_call));
 							}
 						}
 						break;
@@ -1484,16 +1745,22 @@ void MethodOutput::generate(std::ofstream & file)
 							unsigned char b2 = ref[++zz];
 							int idx = ((b1 << 8) + b2);
 							
-							if(ref[zz+1] != OP_dup)
+							if(zz + 1 >= end || ref[zz+1] != OP_dup)
+							{
+								DIAG_AT(DIAG_WARNING, opcodePos, "new is not followed by dup");
+							}
+							else
 							{
-								cerr << "ERROR: after new it's not dup" << endl;
+								zz++; // the reference is pushed by the constructor call
 							}
 							
-							nextInvokeIsNew = true;
+							pendingNews++;
 							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_name = constant_pool[info.ClassInfo.name_index];
-							std::string className = checkClassName(class_name.UTF8Info.bytes);
+							std::string className;
+							if(classConstant(constant_pool, idx, className))
+								className = checkClassName(std::move(className));
+							else
+								className = invalidConstant(opcodePos, c, idx);
 							
 							// jvm_stack.push_back(className);
 							// if(std::find(tmpNames.begin(), tmpNames.end(), className) == tmpNames.end())
@@ -1510,7 +1777,7 @@ void MethodOutput::generate(std::ofstream & file)
 						{
 							int typeId = ref[++zz];
 							std::string type = typeFromInt(typeId);
-							std::string size = jvm_stack.back();
+							std::string size = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("new " + type + "[" + size + "]");
 							varTypes["new " + type + "[" + size + "]"] = type + "[]";
@@ -1522,11 +1789,13 @@ void MethodOutput::generate(std::ofstream & file)
 							unsigned char b2 = ref[++zz];
 							int idx = ((b1 << 8) + b2);
 							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_name = constant_pool[info.ClassInfo.name_index];
-							std::string className = checkClassName(class_name.UTF8Info.bytes);
+							std::string className;
+							if(classConstant(constant_pool, idx, className))
+								className = checkClassName(std::move(className));
+							else
+								className = invalidConstant(opcodePos, c, idx);
 							
-							std::string size = jvm_stack.back();
+							std::string size = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back("new " + className + "[" + size + "]");
 							varTypes["new " + className + "[" + size + "]"] = className + "[]";
@@ -1534,7 +1803,7 @@ void MethodOutput::generate(std::ofstream & file)
 						break;
 					case OP_arraylength:
 						{
-							std::string arr = jvm_stack.back();
+							std::string arr = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							jvm_stack.push_back(arr + ".length");
 						}
@@ -1542,7 +1811,7 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_athrow:
 						{
 							// TODO
-							cerr << "athrow not implemented:" << endl;
+							DIAG_AT(DIAG_WARNING, opcodePos, "athrow not implemented");
 							std::string exception = jvm_stack.back();
 							jvm_stack.clear();
 							jvm_stack.push_back(exception);
@@ -1555,11 +1824,13 @@ void MethodOutput::generate(std::ofstream & file)
 							unsigned char b2 = ref[++zz];
 							int idx = ((b1 << 8) + b2);
 							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_name = constant_pool[info.ClassInfo.name_index];
-							std::string className = checkClassName(class_name.UTF8Info.bytes);
+							std::string className;
+							if(classConstant(constant_pool, idx, className))
+								className = checkClassName(std::move(className));
+							else
+								className = invalidConstant(opcodePos, c, idx);
 							
-							cout << "checkcast " << jvm_stack.back() << " is a " << className << endl;
+							DIAG_AT(DIAG_DEBUG, opcodePos, "checkcast " << jvm_stack.back() << " is a " << className);
 						}
 						break;
 					case OP_instanceof:
@@ -1568,9 +1839,11 @@ void MethodOutput::generate(std::ofstream & file)
 							unsigned char b2 = ref[++zz];
 							int idx = ((b1 << 8) + b2);
 							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_name = constant_pool[info.ClassInfo.name_index];
-							std::string className = checkClassName(class_name.UTF8Info.bytes);
+							std::string className;
+							if(classConstant(constant_pool, idx, className))
+								className = checkClassName(std::move(className));
+							else
+								className = invalidConstant(opcodePos, c, idx);
 							
 							std::string obj = jvm_stack.back();
 							jvm_stack.clear();
@@ -1579,7 +1852,7 @@ void MethodOutput::generate(std::ofstream & file)
 						break;
 					case OP_monitorenter:
 						{
-							std::string obj = jvm_stack.back();
+							std::string obj = std::move(jvm_stack.back());
 							jvm_stack.pop_back();
 							BUFF("synchronized(" + obj + ") {\n");
 						}
@@ -1587,9 +1860,7 @@ void MethodOutput::generate(std::ofstream & file)
 					case OP_monitorexit:
 						{
 							BUFF("}\n");
-							unsigned char nextOpcode = ref[zz + 1];
-							
-							if(nextOpcode == 0xa7) // goto
+							if(zz + 3 < end && static_cast<unsigned char>(ref[zz + 1]) == OP_goto)
 							{
 								unsigned char b1 = ref[zz+2];
 								unsigned char b2 = ref[zz+3];
@@ -1603,7 +1874,7 @@ void MethodOutput::generate(std::ofstream & file)
 						break;
 					case OP_wide:
 						// TODO
-						cerr << "wide not implemented, segfault incoming." << endl;
+						DIAG_AT(DIAG_WARNING, opcodePos, "wide not implemented");
 						break;
 					case OP_multianewarray:
 						{
@@ -1612,12 +1883,15 @@ void MethodOutput::generate(std::ofstream & file)
 							int dimension = ref[++zz];
 							int idx = ((b1 << 8) + b2);
 							
-							CPinfo info = constant_pool[idx];
-							CPinfo class_name = constant_pool[info.ClassInfo.name_index];
-							std::string className = checkClassName(class_name.UTF8Info.bytes);
-							
-							int p = 0;
-							std::string outputType = parseType(className, p);
+							// the descriptor of the array
+							std::string outputType;
+							if(classConstant(constant_pool, idx, outputType))
+							{
+								int p = 0;
+								outputType = parseType(checkClassName(std::move(outputType)), p);
+							}
+							else
+								outputType = invalidConstant(opcodePos, c, idx);
 							std::string type = outputType;
 							auto it = std::find(type.begin(), type.end(), '[');
 							type.erase(it, type.end());
@@ -1625,7 +1899,7 @@ void MethodOutput::generate(std::ofstream & file)
 							std::string dimensions;
 							while(dimension > 0)
 							{
-								std::string size = jvm_stack.back();
+								std::string size = std::move(jvm_stack.back());
 								jvm_stack.pop_back();
 								dimensions = "[" + size + "]" + dimensions;
 								dimension--;
@@ -1644,48 +1918,96 @@ void MethodOutput::generate(std::ofstream & file)
 						break;
 					case OP_goto_w:
 						// TODO
-						cerr << "goto_w not implemented, segfault incoming." << endl;
+						DIAG_AT(DIAG_WARNING, opcodePos, "goto_w not implemented");
 						break;
 					case OP_jsr_w:
 						// TODO
-						cerr << "jsr_w not implemented, segfault incoming." << endl;
+						DIAG_AT(DIAG_WARNING, opcodePos, "jsr_w not implemented");
 						break;
 					case OP_breakpoint:
-						cerr << "reserved for breakpoints in Java debuggers; should not appear in any class file." << endl;
+						DIAG_AT(DIAG_ERROR, opcodePos, "breakpoint is reserved for debuggers and should not appear in a class file");
 						break;
 					/* 0xcb to 0xdf are reserved for future use */
 					case OP_impdep1:
 					case OP_impdep2:
-						cerr << "reserved for implementation-dependent operations within debuggers; should not appear in any class file." << endl;
+						DIAG_AT(DIAG_ERROR, opcodePos, "impdep1/impdep2 are reserved for debuggers and should not appear in a class file");
 						break;
 					default:
-						cerr << "Unhandled opcode:" << std::hex << static_cast<int>(c) << endl;
+						DIAG_AT(DIAG_WARNING, opcodePos, "unhandled opcode 0x" << std::hex << static_cast<int>(c));
 						BUFF("// Unhandled opcode: " + std::to_string(static_cast<int>(c)) + "\n");
 				}
+				// the values pushed take the category of the instruction, but
+				// for those above which moved them themselves
+				if(!topValues)
+				{
+					categories.resize(std::min(jvm_stack.size(), stackBefore - std::max(pops, 0)));
+					categories.resize(jvm_stack.size(), category ? category : 1);
+				}
+				zz = std::max(zz, last);
 			}
 			
-			for(auto & target : jumpTargets)
+			STATS_COUNT(COUNTER_INSTRUCTIONS, instructions);
+			decodedInstructions += instructions;
+			
+			if(exceeded)
+			{
+				DIAG(DIAG_WARNING, exceeded << " budget exceeded, method replaced by a stub");
+				STATS_COUNT(COUNTER_STUBBED_METHODS, 1);
+				writeStub(file, name, code, codeLength, exceeded);
+				complete = false;
+				continue;
+			}
 			{
-				auto pos = std::find(bufferMethod.begin(), bufferMethod.end(), "/*" + std::to_string(target.first) + "*/ ");
-				if(pos != bufferMethod.end())
+				std::uint64_t bytes = 0;
+				for(;bytesCounted < bufferMethod.size();bytesCounted++)
+					bytes += bufferMethod[bytesCounted].size();
+				decodedBytes += bytes;
+				if(classMeter)
+					classMeter->spend(0, bytes);
+			}
+			
+			// the blocks opened and closed by the jumps go before the first
+			// statement of their target, in a single pass over both
+			std::vector<std::string> statements;
+			{
+				STATS_TIMER(STAGE_CONTROL_FLOW);
+				statements.reserve(bufferMethod.size() + jumpTargets.size());
+				auto target = jumpTargets.begin();
+				std::size_t next = 0;
+				for(const auto & start : instructionStarts)
 				{
-					std::string bufferString;
-					for(auto & str : target.second)
+					for(;target != jumpTargets.end() && target->first < start.first;++target)
+						DIAG_AT(DIAG_WARNING, target->first, "jump to the middle of an instruction");
+					
+					if(target != jumpTargets.end() && target->first == start.first)
 					{
-						bufferString += str;
+						for(;next < start.second;next++)
+							statements.push_back(std::move(bufferMethod[next]));
+						
+						std::string bufferString;
+						for(auto & str : target->second)
+						{
+							bufferString += str;
+						}
+						statements.push_back(std::move(bufferString));
+						++target;
 					}
-					
-					bufferMethod.insert(pos, bufferString);
-				}
-				else
-				{
-					cerr << "invalid jump target" << endl;
 				}
+				for(;target != jumpTargets.end();++target)
+					DIAG_AT(DIAG_WARNING, target->first, "jump past the end of the code");
+				for(;next < bufferMethod.size();next++)
+					statements.push_back(std::move(bufferMethod[next]));
 			}
 			
-			for(auto & str : bufferMethod)
+			STATS_TIMER(STAGE_EMIT);
+			if(sink)
 			{
-				if(str[0] != '/') // remove the "/*XX*/ " placeholders
+				for(auto & str : statements)
+					sink->statement(str);
+			}
+			else
+			{
+				for(auto & str : statements)
 					W(str);
 			}
 		}
@@ -1700,5 +2022,212 @@ void MethodOutput::generate(std::ofstream & file)
 			W("*/\n");
 		}
 	}
-	W("}\n\n");
+	return complete;
+}
+
+// everything generate() depends on, with the constant pool indexes
+// replaced by the values they point to; the references to the class itself
+// and to its parent are marked rather than named, so that copies of a
+// method in other classes match, unless their names could be confused
+// with the rest of the key (see memoPinned())
+std::string MethodOutput::memoKey() const
+{
+	std::string key;
+	
+	const bool flags[] = {isPublic(), isProtected(), isPrivate(), isAbstract(), isFinal(), isStatic(), isSynchronized(), isBridge(), isVarargs(), isNative(), isStrict()};
+	for(bool flag : flags)
+		key += flag ? '1' : '0';
+	
+	key += name + '\0' + returnType + '\0';
+	for(const std::string & param : parametersType)
+		key += param + ',';
+	key += '\0';
+	
+	for(const std::tuple<std::string, ByteView> & a : attributes)
+	{
+		key += std::get<0>(a) + '\0';
+		
+		const ByteView & ref = std::get<1>(a);
+		if(std::get<0>(a) != "Code" || ref.size() < 8)
+		{
+			key += std::to_string(ref.size()) + ':';
+			key.append(ref.data(), ref.size());
+			continue;
+		}
+		
+		// only the header and the bytecode are used, not the exception table
+		// nor the sub-attributes
+		const unsigned char * header = reinterpret_cast<const unsigned char *>(ref.data());
+		std::size_t code_size = (header[4] << 24) + (header[5] << 16) + (header[6] << 8) + header[7];
+		code_size = std::min(code_size, ref.size() - 8);
+		
+		std::string code(ref.data(), 8 + code_size);
+		std::string values;
+		const unsigned char * bytecode = header + 8;
+		for(std::size_t pc = 0;pc < code_size;)
+		{
+			std::size_t length = instructionLength(bytecode, pc, code_size);
+			if(length == 0)
+				break;
+			
+			int index = -1;
+			switch(bytecode[pc])
+			{
+				case OP_ldc:
+					index = bytecode[pc + 1];
+					code[8 + pc + 1] = 0;
+					break;
+				case OP_ldc_w:
+				case OP_ldc2_w:
+				case OP_getstatic:
+				case OP_putstatic:
+				case OP_getfield:
+				case OP_putfield:
+				case OP_invokevirtual:
+				case OP_invokespecial:
+				case OP_invokestatic:
+				case OP_invokeinterface:
+				case OP_invokedynamic:
+				case OP_new:
+				case OP_anewarray:
+				case OP_checkcast:
+				case OP_instanceof:
+				case OP_multianewarray:
+					index = (bytecode[pc + 1] << 8) + bytecode[pc + 2];
+					code[8 + pc + 1] = 0;
+					code[8 + pc + 2] = 0;
+					break;
+			}
+			if(index >= 0)
+			{
+				// "C" and the class name, or "R", the class constant and the member
+				std::string value = resolveConstant(*pool, index);
+				std::string referenced;
+				std::uint16_t classIndex = 0;
+				std::size_t at = 1;
+				if(value[0] == 'C')
+					classIndex = index;
+				else if(value[0] == 'R')
+				{
+					classIndex = (*pool)[index].RefInfo.class_index;
+					at = 2;
+				}
+				
+				char mark = 0;
+				if(classIndex && classConstant(*pool, classIndex, referenced) && value.compare(at, referenced.size(), referenced) == 0)
+				{
+					if(referenced == thisClass)
+						mark = MEMO_CLASS;
+					else if(checkClassName(referenced) == parentClass)
+						mark = MEMO_PARENT;
+				}
+				if(mark)
+				{
+					values.append(value, 0, at);
+					values += MEMO_MARK;
+					values += mark;
+					appendMemoEscaped(values, value.data() + at + referenced.size(), value.size() - at - referenced.size());
+				}
+				else
+				{
+					appendMemoEscaped(values, value.data(), value.size());
+				}
+				values += '\0';
+			}
+			
+			pc += length;
+		}
+		
+		key += std::to_string(code.size()) + ':' + code + std::to_string(values.size()) + ':' + values;
+	}
+	
+	// how the names compare, which the decoder checks
+	std::string javaClass = checkClassName(thisClass);
+	key += javaClass == thisClass ? '1' : '0';
+	key += javaClass == parentClass ? '1' : '0';
+	key += parentClass == "Object" ? '1' : '0';
+	
+	bool prefixes = namePrefixes(thisClass, parentClass) || namePrefixes(javaClass, parentClass) || namePrefixes(thisClass, javaClass);
+	bool pinClass = prefixes || memoPinned(key, thisClass) || memoPinned(key, javaClass);
+	bool pinParent = prefixes || memoPinned(key, parentClass);
+	if(pinClass)
+		key += '\0' + thisClass;
+	if(pinParent)
+		key += '\0' + parentClass;
+	
+	return key;
+}
+
+std::string MethodOutput::memoText(const std::string & text) const
+{
+	std::string javaClass = checkClassName(thisClass);
+	const std::pair<const std::string *, char> names[] = {
+		std::make_pair(&thisClass, MEMO_CLASS),
+		std::make_pair(&javaClass, MEMO_JAVA_CLASS),
+		std::make_pair(&parentClass, MEMO_PARENT)
+	};
+	
+	std::string marked;
+	marked.reserve(text.size());
+	for(std::size_t i = 0;i < text.size();)
+	{
+		char mark = 0;
+		std::size_t length = 0;
+		if(isNameChar(text[i]) && (i == 0 || !isNameChar(text[i - 1])))
+		{
+			// the longest, when one name starts another
+			for(const auto & name : names)
+			{
+				const std::string & candidate = *name.first;
+				if(candidate.size() > length && text.compare(i, candidate.size(), candidate) == 0 && memoNameEnds(text, i + candidate.size()))
+				{
+					mark = name.second;
+					length = candidate.size();
+				}
+			}
+		}
+		
+		if(mark)
+		{
+			marked += MEMO_MARK;
+			marked += mark;
+			i += length;
+		}
+		else
+		{
+			appendMemoEscaped(marked, text.data() + i, 1);
+			i++;
+		}
+	}
+	return marked;
+}
+
+std::string MethodOutput::memoRestore(const std::string & text) const
+{
+	std::string restored;
+	restored.reserve(text.size());
+	for(std::size_t i = 0;i < text.size();i++)
+	{
+		if(text[i] != MEMO_MARK || i + 1 == text.size())
+		{
+			restored += text[i];
+			continue;
+		}
+		
+		switch(text[++i])
+		{
+			case MEMO_CLASS:
+				restored += thisClass;
+				break;
+			case MEMO_JAVA_CLASS:
+				restored += checkClassName(thisClass);
+				break;
+			case MEMO_PARENT:
+				restored += parentClass;
+				break;
+			default:
+				restored += text[i];
+		}
+	}
+	return restored;
 }
@@ -25,34 +25,72 @@ freely, subject to the following restrictions:
 #ifndef METHODOUTPUT_H
 #define METHODOUTPUT_H
 
+#include "Budget.h"
+#include "ByteView.h"
 #include "CPinfo.h"
+#include "defines.h"
+#include <cstdint>
+#include <ostream>
 #include <string>
 #include <tuple>
 #include <vector>
 
+// whether an ldc of a constant with this tag is turned into Java
+bool constantLoadDecompiled(std::uint8_t tag);
+
+// receives the body of a method in place of the output stream, see
+// MethodOutput::generateBody
+class StatementSink
+{
+public:
+	virtual ~StatementSink() {}
+	// a statement, or the opening or closing line of a block; a string may
+	// hold several lines, each ending with '\n'
+	virtual void statement(const std::string & text) = 0;
+};
+
 class MethodOutput
 {
 public:
-	void generate(std::ofstream & file);
+	// returns false if the method ran out of budget and a stub was written
+	// in place of its body
+	bool generate(std::ostream & file);
+	// the body alone, between the braces; with a sink the decompiled code
+	// goes to it and only the comments and stubs are written to file
+	bool generateBody(std::ostream & file, StatementSink * sink = nullptr);
+	std::string memoKey() const;
+	// a generated text with the names of the class and of its parent
+	// replaced by markers, so that it can be reused by the other classes
+	// with the same memoKey(); memoRestore() puts this class's names back
+	std::string memoText(const std::string & text) const;
+	std::string memoRestore(const std::string & text) const;
 	
 	std::string name;
 	std::string returnType;
 	std::vector<std::string> parametersType;
-	std::vector<std::tuple<std::string, std::string>> attributes;
-	bool isPublic = false,
-		 isProtected = false,
-		 isPrivate = false,
-		 isAbstract = false,
-		 isFinal = false,
-		 isStatic = false,
-		 isSynchronized = false,
-		 isBridge = false,
-		 isVarargs = false,
-		 isNative = false,
-		 isStrict = false;
+	// the data points into the class file buffer
+	std::vector<std::tuple<std::string, ByteView>> attributes;
+	std::uint16_t accessFlags = 0; // ACC_ bits, see defines.h
+	bool isPublic() const { return (accessFlags & ACC_PUBLIC) != 0; }
+	bool isProtected() const { return (accessFlags & ACC_PROTECTED) != 0; }
+	bool isPrivate() const { return (accessFlags & ACC_PRIVATE) != 0; }
+	bool isAbstract() const { return (accessFlags & ACC_ABSTRACT) != 0; }
+	bool isFinal() const { return (accessFlags & ACC_FINAL) != 0; }
+	bool isStatic() const { return (accessFlags & ACC_STATIC) != 0; }
+	bool isSynchronized() const { return (accessFlags & ACC_SYNCHRONIZED) != 0; }
+	bool isBridge() const { return (accessFlags & ACC_BRIDGE) != 0; }
+	bool isVarargs() const { return (accessFlags & ACC_VARARGS) != 0; }
+	bool isNative() const { return (accessFlags & ACC_NATIVE) != 0; }
+	bool isStrict() const { return (accessFlags & ACC_STRICT) != 0; }
 	//
 	std::string thisClass;
 	std::string parentClass;
+	const ConstantPool * pool = nullptr;
+	const Budget * budget = nullptr; // of this method alone
+	BudgetMeter * classMeter = nullptr; // shared by the methods of the class
+	// spent by generate(), for the memo to charge the class meter again
+	std::uint64_t decodedInstructions = 0;
+	std::uint64_t decodedBytes = 0;
 };
 
 #endif
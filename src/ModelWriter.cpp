@@ -0,0 +1,485 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "ModelWriter.h"
+#include "Helpers.h"
+#include "Json.h"
+#include "Stats.h"
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+struct FlagName
+{
+	std::uint16_t flag;
+	const char * name;
+};
+
+const FlagName classFlagNames[] = {{0x0001, "public"}, {0x0010, "final"}, {0x0200, "interface"}, {0x0400, "abstract"}, {0x2000, "annotation"}, {0x4000, "enum"}};
+const FlagName fieldFlagNames[] = {{0x0001, "public"}, {0x0002, "private"}, {0x0004, "protected"}, {0x0008, "static"}, {0x0010, "final"}, {0x0040, "volatile"}, {0x0080, "transient"}};
+const FlagName methodFlagNames[] = {{0x0001, "public"}, {0x0002, "private"}, {0x0004, "protected"}, {0x0008, "static"}, {0x0010, "final"}, {0x0020, "synchronized"}, {0x0040, "bridge"}, {0x0080, "varargs"}, {0x0100, "native"}, {0x0400, "abstract"}, {0x0800, "strict"}};
+
+std::uint16_t flag(bool set, std::uint16_t value)
+{
+	return set ? value : 0;
+}
+
+std::uint16_t classFlags(const ClassOutput & c)
+{
+	return flag(c.isPublic, 0x0001) | flag(c.isFinal, 0x0010) | flag(c.isInterface, 0x0200) | flag(c.isAbstract, 0x0400) | flag(c.isAnnotation, 0x2000) | flag(c.isEnum, 0x4000);
+}
+
+// those of fieldFlagNames and methodFlagNames; synthetic, enum and the
+// unknown bits are left out
+std::uint16_t fieldFlags(const FieldOutput & f)
+{
+	return f.accessFlags & 0x00DF;
+}
+
+std::uint16_t methodFlags(const MethodOutput & m)
+{
+	return m.accessFlags & 0x0DFF;
+}
+
+// the name generate() gives to parameter i, "i1" for the first int of an
+// instance method
+std::string parameterName(const MethodOutput & method, std::size_t i)
+{
+	return letterFromType(method.parametersType[i]) + std::to_string(i + (method.isStatic() ? 0 : 1));
+}
+
+// receives the class in output order; BodySplitter keeps the blocks balanced
+class ModelEncoder
+{
+public:
+	virtual ~ModelEncoder() {}
+	// everything but the methods
+	virtual void beginClass(const ClassOutput & output) = 0;
+	virtual void beginMethod(const MethodOutput & method) = 0;
+	virtual void statement(const char * text, std::size_t length) = 0;
+	virtual void openBlock(const char * header, std::size_t length) = 0;
+	virtual void closeBlock(const char * closing, std::size_t length) = 0;
+	virtual void endMethod(bool complete, const std::string & notes) = 0;
+	virtual void endClass() = 0;
+};
+
+class JsonEncoder : public ModelEncoder
+{
+public:
+	JsonEncoder(std::ostream & file)
+		: file(file)
+	{
+	}
+	
+	void beginClass(const ClassOutput & output) override
+	{
+		file << "{\"class\":";
+		writeJsonString(file, output.name);
+		file << ",\"extends\":";
+		writeJsonString(file, output.extends);
+		file << ",\"flags\":";
+		writeFlags(classFlags(output), classFlagNames, sizeof(classFlagNames) / sizeof(classFlagNames[0]));
+		file << ",\"interfaces\":[";
+		for(std::size_t i = 0;i < output.interfaces.size();i++)
+		{
+			if(i)
+				file << ',';
+			writeJsonString(file, output.interfaces[i]);
+		}
+		file << "],\"fields\":[";
+		for(std::size_t i = 0;i < output.fields.size();i++)
+		{
+			const FieldOutput field = output.field(i);
+			file << (i ? ",{\"name\":" : "{\"name\":");
+			writeJsonString(file, field.name);
+			file << ",\"type\":";
+			writeJsonString(file, field.type);
+			file << ",\"flags\":";
+			writeFlags(fieldFlags(field), fieldFlagNames, sizeof(fieldFlagNames) / sizeof(fieldFlagNames[0]));
+			file << '}';
+		}
+		file << "],\"methods\":[";
+		firstMethod = true;
+	}
+	
+	void beginMethod(const MethodOutput & method) override
+	{
+		file << (firstMethod ? "{\"name\":" : ",{\"name\":");
+		firstMethod = false;
+		writeJsonString(file, method.name);
+		file << ",\"returns\":";
+		writeJsonString(file, method.returnType);
+		file << ",\"flags\":";
+		writeFlags(methodFlags(method), methodFlagNames, sizeof(methodFlagNames) / sizeof(methodFlagNames[0]));
+		file << ",\"parameters\":[";
+		for(std::size_t i = 0;i < method.parametersType.size();i++)
+		{
+			file << (i ? ",{\"type\":" : "{\"type\":");
+			writeJsonString(file, method.parametersType[i]);
+			file << ",\"name\":";
+			writeJsonString(file, parameterName(method, i));
+			file << '}';
+		}
+		file << "],\"body\":[";
+		comma = false;
+	}
+	
+	void statement(const char * text, std::size_t length) override
+	{
+		if(comma)
+			file << ',';
+		writeJsonString(file, text, length);
+		comma = true;
+	}
+	
+	void openBlock(const char * header, std::size_t length) override
+	{
+		file << (comma ? ",{\"block\":" : "{\"block\":");
+		writeJsonString(file, header, length);
+		file << ",\"body\":[";
+		comma = false;
+	}
+	
+	void closeBlock(const char * closing, std::size_t length) override
+	{
+		file << ']';
+		if(length)
+		{
+			file << ",\"closing\":";
+			writeJsonString(file, closing, length);
+		}
+		file << '}';
+		comma = true;
+	}
+	
+	void endMethod(bool complete, const std::string & notes) override
+	{
+		file << (complete ? "],\"complete\":true" : "],\"complete\":false");
+		if(!notes.empty())
+		{
+			file << ",\"notes\":";
+			writeJsonString(file, notes);
+		}
+		file << '}';
+	}
+	
+	void endClass() override
+	{
+		file << "]}\n";
+	}
+
+private:
+	void writeFlags(std::uint16_t flags, const FlagName * names, std::size_t count)
+	{
+		file << '[';
+		bool first = true;
+		for(std::size_t i = 0;i < count;i++)
+		{
+			if(flags & names[i].flag)
+			{
+				file << (first ? "\"" : ",\"") << names[i].name << '"';
+				first = false;
+			}
+		}
+		file << ']';
+	}
+	
+	std::ostream & file;
+	bool firstMethod = true;
+	bool comma = false; // the current array already has an element
+};
+
+// the nodes are written into one buffer, their sizes filled in when they
+// end, and the whole class is written out at once
+class BinaryEncoder : public ModelEncoder
+{
+public:
+	BinaryEncoder(std::ostream & file)
+		: file(file)
+	{
+	}
+	
+	void beginClass(const ClassOutput & output) override
+	{
+		buffer.append("JDQM", 4);
+		u2(MODEL_BINARY_VERSION);
+		u2(0);
+		
+		begin(MODEL_CLASS, classFlags(output));
+		string(output.name.data(), output.name.size());
+		string(output.extends.data(), output.extends.size());
+		for(const std::string & name : output.interfaces)
+			leaf(MODEL_INTERFACE, name.data(), name.size());
+		for(std::size_t i = 0;i < output.fields.size();i++)
+		{
+			const FieldOutput field = output.field(i);
+			begin(MODEL_FIELD, fieldFlags(field));
+			string(field.type.data(), field.type.size());
+			string(field.name.data(), field.name.size());
+			end();
+		}
+	}
+	
+	void beginMethod(const MethodOutput & method) override
+	{
+		begin(MODEL_METHOD, methodFlags(method));
+		string(method.name.data(), method.name.size());
+		string(method.returnType.data(), method.returnType.size());
+		for(std::size_t i = 0;i < method.parametersType.size();i++)
+		{
+			const std::string & type = method.parametersType[i];
+			std::string name = parameterName(method, i);
+			begin(MODEL_PARAMETER, 0);
+			string(type.data(), type.size());
+			string(name.data(), name.size());
+			end();
+		}
+	}
+	
+	void statement(const char * text, std::size_t length) override
+	{
+		leaf(MODEL_STATEMENT, text, length);
+	}
+	
+	void openBlock(const char * header, std::size_t length) override
+	{
+		begin(MODEL_BLOCK, 0);
+		string(header, length);
+	}
+	
+	void closeBlock(const char * closing, std::size_t length) override
+	{
+		if(length)
+			leaf(MODEL_CLOSING, closing, length);
+		end();
+	}
+	
+	void endMethod(bool complete, const std::string & notes) override
+	{
+		if(!notes.empty())
+			leaf(MODEL_NOTE, notes.data(), notes.size());
+		if(!complete)
+			buffer[open.back() + 7] |= static_cast<char>(MODEL_INCOMPLETE >> 8); // high byte of the flags
+		end();
+	}
+	
+	void endClass() override
+	{
+		end();
+		file.write(buffer.data(), buffer.size());
+	}
+
+private:
+	void u2(std::uint16_t value)
+	{
+		buffer += static_cast<char>(value & 0xff);
+		buffer += static_cast<char>(value >> 8);
+	}
+	
+	void u4(std::uint32_t value)
+	{
+		u2(value & 0xffff);
+		u2(value >> 16);
+	}
+	
+	void begin(ModelNodeKind kind, std::uint16_t flags)
+	{
+		open.push_back(buffer.size());
+		u4(0);
+		buffer += static_cast<char>(kind);
+		buffer += '\0';
+		u2(flags);
+	}
+	
+	void end()
+	{
+		std::size_t start = open.back();
+		open.pop_back();
+		std::uint32_t size = static_cast<std::uint32_t>(buffer.size() - start);
+		for(int i = 0;i < 4;i++)
+			buffer[start + i] = static_cast<char>(size >> (8 * i));
+	}
+	
+	void string(const char * text, std::size_t length)
+	{
+		u4(static_cast<std::uint32_t>(length));
+		buffer.append(text, length);
+	}
+	
+	void leaf(ModelNodeKind kind, const char * text, std::size_t length)
+	{
+		begin(kind, 0);
+		string(text, length);
+		end();
+	}
+	
+	std::ostream & file;
+	std::string buffer;
+	std::vector<std::size_t> open; // offsets of the nodes not ended yet
+};
+
+const char * trimmed(const char * text, std::size_t & length)
+{
+	while(length && *text == ' ')
+	{
+		text++;
+		length--;
+	}
+	while(length && text[length - 1] == ' ')
+		length--;
+	return text;
+}
+
+// turns the strings MethodOutput::generateBody gives into statements and
+// blocks: a line ending with '{' opens a block, one starting with '}'
+// closes it, and the other lines of a string are a single statement, as
+// the string constants in it may hold line feeds
+class BodySplitter : public StatementSink
+{
+public:
+	BodySplitter(ModelEncoder & encoder)
+		: encoder(encoder)
+	{
+	}
+	
+	void statement(const std::string & text) override
+	{
+		const char * data = text.data();
+		std::size_t pending = 0; // start of the lines of the statement
+		std::size_t pos = 0;
+		while(pos < text.size())
+		{
+			const char * eol = static_cast<const char *>(std::memchr(data + pos, '\n', text.size() - pos));
+			std::size_t next = eol ? eol - data + 1 : text.size();
+			std::size_t length = (eol ? eol - data : text.size()) - pos;
+			const char * line = trimmed(data + pos, length);
+			bool closes = length && line[0] == '}';
+			bool opens = length && line[length - 1] == '{';
+			if(closes || opens)
+			{
+				flush(data + pending, pos - pending);
+				if(closes)
+				{
+					line++;
+					length--;
+					if(opens)
+					{
+						close("", 0); // "} else {"
+					}
+					else
+					{
+						line = trimmed(line, length);
+						close(line, length);
+					}
+				}
+				if(opens)
+				{
+					length--;
+					line = trimmed(line, length);
+					depth++;
+					encoder.openBlock(line, length);
+				}
+				pending = next;
+			}
+			pos = next;
+		}
+		flush(data + pending, text.size() - pending);
+	}
+	
+	// closes what the method left open
+	void finish()
+	{
+		while(depth)
+			close("", 0);
+	}
+
+private:
+	void flush(const char * text, std::size_t length)
+	{
+		while(length && text[length - 1] == '\n')
+			length--;
+		text = trimmed(text, length);
+		if(length)
+			encoder.statement(text, length);
+	}
+	
+	void close(const char * closing, std::size_t length)
+	{
+		if(depth == 0)
+		{
+			// nothing to close, kept as it is
+			encoder.statement("}", 1);
+			if(length)
+				encoder.statement(closing, length);
+			return;
+		}
+		depth--;
+		encoder.closeBlock(closing, length);
+	}
+	
+	ModelEncoder & encoder;
+	unsigned depth = 0;
+};
+
+unsigned encodeClass(const ClassOutput & output, ModelEncoder & encoder)
+{
+	BudgetMeter classMeter(output.classBudget);
+	unsigned stubs = 0;
+	std::ostringstream notes;
+	
+	encoder.beginClass(output);
+	for(std::size_t i = 0;i < output.methods.size();i++)
+	{
+		MethodOutput m = output.method(i);
+		m.budget = &output.methodBudget;
+		m.classMeter = output.classBudget.isSet() ? &classMeter : nullptr;
+		
+		encoder.beginMethod(m);
+		BodySplitter body(encoder);
+		notes.str("");
+		bool complete = m.generateBody(notes, &body);
+		body.finish();
+		if(!complete)
+			stubs++;
+		encoder.endMethod(complete, notes.str());
+	}
+	encoder.endClass();
+	return stubs;
+}
+
+}
+
+unsigned writeModel(const ClassOutput & output, ModelEncoding encoding, std::ostream & file)
+{
+	STATS_TIMER(STAGE_EMIT);
+	if(encoding == MODEL_BINARY)
+	{
+		BinaryEncoder encoder(file);
+		return encodeClass(output, encoder);
+	}
+	JsonEncoder encoder(file);
+	return encodeClass(output, encoder);
+}
@@ -0,0 +1,98 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef MODELWRITER_H
+#define MODELWRITER_H
+
+#include <cstdint>
+#include <ostream>
+
+#include "ClassOutput.h"
+
+// the decompiled class as data rather than Java text, for tools which would
+// otherwise parse the generated code again
+//
+// a method body is a tree of statements and blocks: each block has a header
+// ("if(i1 > 3)", "else", "do", "synchronized(a1)"), a body and, for do loops,
+// a closing ("while(i1 < 3);"); the statements and headers are the Java text
+// generate() writes, without the braces and the line feeds
+enum ModelEncoding
+{
+	MODEL_JSON = 0, // one object per class, see writeModel
+	MODEL_BINARY
+};
+
+// flags of the binary nodes: the access_flags of the class file, rebuilt from
+// the parsed model, and one bit of our own
+const std::uint16_t MODEL_INCOMPLETE = 0x8000; // method body replaced by a stub
+
+// binary node kinds
+enum ModelNodeKind
+{
+	MODEL_CLASS = 1,
+	MODEL_INTERFACE,
+	MODEL_FIELD,
+	MODEL_METHOD,
+	MODEL_PARAMETER,
+	MODEL_STATEMENT,
+	MODEL_BLOCK,
+	MODEL_CLOSING,
+	MODEL_NOTE
+};
+
+// "JDQM", then a little endian u16 version and u16 zero
+const std::uint16_t MODEL_BINARY_VERSION = 1;
+
+// JSON:
+//   {"class": name, "extends": name, "flags": [...], "interfaces": [...],
+//    "fields": [{"name", "type", "flags"}],
+//    "methods": [{"name", "returns", "flags", "parameters": [{"type", "name"}],
+//                 "body": [...], "complete", "notes"}]}
+//   a statement of a body is a string, a block {"block": header, "body": [...]}
+//   with "closing" when it has one; notes are the comments (and stubs) the
+//   Java output has outside the code
+//
+// binary, made to be read in place from a mapped file: the 8 byte header,
+// then the class node; everything little endian and unaligned. A node is
+//   u32 size  of the whole node, header included, to skip it
+//   u8  kind  ModelNodeKind
+//   u8  zero
+//   u16 flags
+// followed by its strings, each a u32 length and the bytes, then by the
+// nodes it contains:
+//   class      name, extends; interface, field and method nodes
+//   interface  name
+//   field      type, name
+//   method     name, return type; parameter, statement and block nodes,
+//              then a note node if there are notes
+//   parameter  type, name
+//   statement  text
+//   block      header; statement and block nodes, then a closing node
+//   closing    text
+//   note       text
+//
+// returns the number of methods replaced by stubs for running out of budget
+unsigned writeModel(const ClassOutput & output, ModelEncoding encoding, std::ostream & file);
+
+#endif
@@ -0,0 +1,213 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "ModifiedUtf8.h"
+#include <cstdint>
+#include <cstring>
+
+// JDQ_NO_SIMD leaves only the portable scan
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(JDQ_NO_SIMD)
+#define JDQ_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// a raw zero byte is not valid modified UTF-8, so the fast paths stop on it
+// as well as on the bytes from 0x80
+
+std::size_t asciiPrefixScalar(const unsigned char * s, std::size_t length)
+{
+	const std::uint64_t high = 0x8080808080808080ULL;
+	const std::uint64_t low = 0x0101010101010101ULL;
+	std::size_t i = 0;
+	for(;i + 8 <= length;i += 8)
+	{
+		std::uint64_t word;
+		std::memcpy(&word, s + i, 8);
+		// a byte has its high bit set, or is zero
+		if((word | ((word - low) & ~word)) & high)
+			break;
+	}
+	while(i < length && s[i] != 0 && s[i] < 0x80)
+		i++;
+	return i;
+}
+
+#ifdef JDQ_X86_SIMD
+
+// the bits of the 16 bytes at s which are zero or from 0x80
+inline int stopMask16(const unsigned char * s)
+{
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+	return _mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, _mm_setzero_si128())));
+}
+
+// SSE2 is always there on x86-64
+std::size_t asciiPrefixSse2(const unsigned char * s, std::size_t length)
+{
+	std::size_t i = 0;
+	for(;i + 16 <= length;i += 16)
+	{
+		int mask = stopMask16(s + i);
+		if(mask)
+			return i + __builtin_ctz(mask);
+	}
+	return i + asciiPrefixScalar(s + i, length - i);
+}
+
+__attribute__((target("avx2")))
+std::size_t asciiPrefixAvx2(const unsigned char * s, std::size_t length)
+{
+	std::size_t i = 0;
+	for(;i + 32 <= length;i += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+		unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(v, _mm256_cmpeq_epi8(v, _mm256_setzero_si256()))));
+		if(mask)
+			return i + __builtin_ctz(mask);
+	}
+	// the compiler leaves out the vzeroupper before the call below, and the
+	// next SSE code pays for the dirty upper halves more than the whole scan
+	// of a short string costs
+	_mm256_zeroupper();
+	if(i + 16 <= length)
+	{
+		int mask = stopMask16(s + i);
+		if(mask)
+			return i + __builtin_ctz(mask);
+		i += 16;
+	}
+	return i + asciiPrefixScalar(s + i, length - i);
+}
+
+#endif
+
+typedef std::size_t (*AsciiPrefix)(const unsigned char * s, std::size_t length);
+
+AsciiPrefix selectAsciiPrefix()
+{
+#ifdef JDQ_X86_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return asciiPrefixAvx2;
+	return asciiPrefixSse2;
+#else
+	return asciiPrefixScalar;
+#endif
+}
+
+bool continuation(unsigned char c)
+{
+	return (c & 0xC0) == 0x80;
+}
+
+// the length of the sequence starting at s, 0 if it is malformed
+std::size_t decodeSequence(const unsigned char * s, std::size_t length, std::uint32_t & code)
+{
+	unsigned char c = s[0];
+	if(c >= 0xC0 && c < 0xE0 && length >= 2 && continuation(s[1]))
+	{
+		code = (c & 0x1Fu) << 6 | (s[1] & 0x3Fu);
+		// C0 80 is NUL, the other overlong forms are not allowed
+		if(code >= 0x80 || (c == 0xC0 && s[1] == 0x80))
+			return 2;
+	}
+	else if(c >= 0xE0 && c < 0xF0 && length >= 3 && continuation(s[1]) && continuation(s[2]))
+	{
+		code = (c & 0x0Fu) << 12 | (s[1] & 0x3Fu) << 6 | (s[2] & 0x3Fu);
+		if(code >= 0x800)
+			return 3;
+	}
+	return 0;
+}
+
+void appendCodePoint(std::vector<char> & out, std::uint32_t code)
+{
+	if(code < 0x80)
+		out.push_back(static_cast<char>(code));
+	else if(code < 0x800)
+	{
+		out.push_back(static_cast<char>(0xC0 | code >> 6));
+		out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+	}
+	else if(code < 0x10000)
+	{
+		out.push_back(static_cast<char>(0xE0 | code >> 12));
+		out.push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+	}
+	else
+	{
+		out.push_back(static_cast<char>(0xF0 | code >> 18));
+		out.push_back(static_cast<char>(0x80 | (code >> 12 & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+	}
+}
+
+}
+
+std::size_t asciiPrefixLength(const char * bytes, std::size_t length)
+{
+	static const AsciiPrefix scan = selectAsciiPrefix();
+	return scan(reinterpret_cast<const unsigned char *>(bytes), length);
+}
+
+bool decodeModifiedUtf8(const char * bytes, std::size_t length, std::vector<char> & out)
+{
+	const unsigned char * s = reinterpret_cast<const unsigned char *>(bytes);
+	bool valid = true;
+	std::size_t i = 0;
+	while(i < length)
+	{
+		// nearly all the constants are plain ASCII, copied in one go
+		std::size_t ascii = asciiPrefixLength(bytes + i, length - i);
+		out.insert(out.end(), bytes + i, bytes + i + ascii);
+		i += ascii;
+		if(i == length)
+			break;
+		
+		std::uint32_t code;
+		std::size_t n = decodeSequence(s + i, length - i, code);
+		if(n == 0)
+		{
+			valid = false;
+			appendCodePoint(out, 0xFFFD);
+			i++;
+			continue;
+		}
+		i += n;
+		
+		// a high surrogate followed by a low one is a single character
+		std::uint32_t low;
+		if(code >= 0xD800 && code < 0xDC00 && i < length && decodeSequence(s + i, length - i, low) == 3 && low >= 0xDC00 && low < 0xE000)
+		{
+			code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+			i += 3;
+		}
+		appendCodePoint(out, code);
+	}
+	return valid;
+}
@@ -0,0 +1,41 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef MODIFIEDUTF8_H
+#define MODIFIEDUTF8_H
+
+#include <cstddef>
+#include <vector>
+
+// appends to out the standard UTF-8 form of the modified UTF-8 of a class
+// file, where NUL is written C0 80 and the characters above U+FFFF as two
+// 3-byte surrogates; a lone surrogate is kept as its 3-byte sequence, a
+// malformed sequence becomes U+FFFD and makes the function return false
+bool decodeModifiedUtf8(const char * bytes, std::size_t length, std::vector<char> & out);
+
+// the number of ASCII bytes at the start, scanned with AVX2 or SSE2 when the
+// processor has them
+std::size_t asciiPrefixLength(const char * bytes, std::size_t length);
+
+#endif
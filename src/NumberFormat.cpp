@@ -0,0 +1,317 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "NumberFormat.h"
+#include <cmath>
+#include <cstring>
+
+// a number f * 2^e, f holding 64 significant bits once normalized
+struct DiyFp
+{
+	std::uint64_t f;
+	int e;
+};
+
+// normalized 10^k for k = -348, -340, ..., 340
+static const std::uint64_t cachedPowersF[] = {
+	0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+	0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+	0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+	0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+	0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+	0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+	0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+	0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+	0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+	0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+	0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+	0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+	0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+	0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+	0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+	0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+	0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+	0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+	0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+	0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+	0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+	0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+	0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+	0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+	0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+	0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+	0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+	0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+	0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+static const std::int16_t cachedPowersE[] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+	-901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+	-582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+	-263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+	56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+	694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+	1013, 1039, 1066,
+};
+
+static const std::uint32_t powersOf10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+static DiyFp multiply(const DiyFp & x, const DiyFp & y)
+{
+	// upper 64 bits of the 128 bit product, rounded
+	const std::uint64_t mask = 0xFFFFFFFFULL;
+	std::uint64_t a = x.f >> 32, b = x.f & mask, c = y.f >> 32, d = y.f & mask;
+	std::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	std::uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+	return DiyFp{ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64};
+}
+
+static DiyFp normalize(DiyFp x)
+{
+	while(!(x.f & (1ULL << 63)))
+	{
+		x.f <<= 1;
+		x.e--;
+	}
+	return x;
+}
+
+// the power c = 10^-k for which the product with a number of binary
+// exponent e lands in the exponent range DigitGen works with
+static DiyFp cachedPower(int e, int & k)
+{
+	double dk = (-61 - e) * 0.30102999566398114 + 347;
+	int ik = static_cast<int>(dk);
+	if(dk - ik > 0.0)
+		ik++;
+	unsigned index = static_cast<unsigned>((ik >> 3) + 1);
+	k = -(-348 + static_cast<int>(index << 3));
+	return DiyFp{cachedPowersF[index], cachedPowersE[index]};
+}
+
+static int countDigits(std::uint32_t n)
+{
+	int digits = 1;
+	while(digits < 10 && n >= powersOf10[digits])
+		digits++;
+	return digits;
+}
+
+static void grisuRound(char * buffer, int length, std::uint64_t delta, std::uint64_t rest, std::uint64_t tenKappa, std::uint64_t distance)
+{
+	while(rest < distance && delta - rest >= tenKappa && (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance))
+	{
+		buffer[length - 1]--;
+		rest += tenKappa;
+	}
+}
+
+// the digits of high, as few as keep them within delta of it
+static void digitGen(const DiyFp & w, const DiyFp & high, std::uint64_t delta, char * buffer, int & length, int & k)
+{
+	const DiyFp one = {1ULL << -high.e, high.e};
+	const std::uint64_t distance = high.f - w.f;
+	std::uint32_t integral = static_cast<std::uint32_t>(high.f >> -one.e);
+	std::uint64_t fractional = high.f & (one.f - 1);
+	int kappa = countDigits(integral);
+	length = 0;
+	
+	while(kappa > 0)
+	{
+		std::uint32_t d = integral / powersOf10[kappa - 1];
+		integral %= powersOf10[kappa - 1];
+		if(d || length)
+			buffer[length++] = static_cast<char>('0' + d);
+		kappa--;
+		std::uint64_t rest = (static_cast<std::uint64_t>(integral) << -one.e) + fractional;
+		if(rest <= delta)
+		{
+			k += kappa;
+			grisuRound(buffer, length, delta, rest, static_cast<std::uint64_t>(powersOf10[kappa]) << -one.e, distance);
+			return;
+		}
+	}
+	
+	for(;;)
+	{
+		fractional *= 10;
+		delta *= 10;
+		char d = static_cast<char>(fractional >> -one.e);
+		if(d || length)
+			buffer[length++] = static_cast<char>('0' + d);
+		fractional &= one.f - 1;
+		kappa--;
+		if(fractional < delta)
+		{
+			k += kappa;
+			int index = -kappa;
+			grisuRound(buffer, length, delta, fractional, one.f, index < 10 ? distance * powersOf10[index] : 0);
+			return;
+		}
+	}
+}
+
+// digits * 10^k is the shortest (almost always) decimal within the
+// rounding interval of significand * 2^exponent; hidden is the implicit
+// bit of the format, closer the lower neighbour being half as far
+static void grisu2(std::uint64_t significand, int exponent, std::uint64_t hidden, char * buffer, int & length, int & k)
+{
+	DiyFp v = {significand, exponent};
+	DiyFp high = normalize(DiyFp{(v.f << 1) + 1, v.e - 1});
+	DiyFp low = significand == hidden ? DiyFp{(v.f << 2) - 1, v.e - 2} : DiyFp{(v.f << 1) - 1, v.e - 1};
+	low.f <<= low.e - high.e;
+	low.e = high.e;
+	
+	DiyFp c = cachedPower(high.e, k);
+	DiyFp w = multiply(normalize(v), c);
+	DiyFp wHigh = multiply(high, c);
+	DiyFp wLow = multiply(low, c);
+	// one unit off each bound for the imprecision of the multiplications
+	wLow.f++;
+	wHigh.f--;
+	digitGen(w, wHigh, wHigh.f - wLow.f, buffer, length, k);
+}
+
+// appends digits * 10^k like Java: plain between 10^-3 and 10^7, with an
+// exponent outside
+static void appendDecimal(std::string & text, const char * digits, int length, int k)
+{
+	int exponent = length + k - 1; // of the first digit
+	if(exponent >= -3 && exponent < 7)
+	{
+		if(exponent < 0)
+		{
+			text += "0.";
+			text.append(-exponent - 1, '0');
+			text.append(digits, length);
+		}
+		else if(length <= exponent + 1)
+		{
+			text.append(digits, length);
+			text.append(exponent + 1 - length, '0');
+			text += ".0";
+		}
+		else
+		{
+			text.append(digits, exponent + 1);
+			text += '.';
+			text.append(digits + exponent + 1, length - exponent - 1);
+		}
+	}
+	else
+	{
+		text += digits[0];
+		text += '.';
+		if(length > 1)
+			text.append(digits + 1, length - 1);
+		else
+			text += '0';
+		text += 'E';
+		text += std::to_string(exponent);
+	}
+}
+
+std::string formatDouble(double value)
+{
+	if(std::isnan(value))
+		return "NaN";
+	
+	std::uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	std::string text = bits >> 63 ? "-" : "";
+	if(std::isinf(value))
+		return text + "Infinity";
+	
+	const std::uint64_t hidden = 1ULL << 52;
+	std::uint64_t significand = bits & (hidden - 1);
+	int biased = static_cast<int>((bits >> 52) & 0x7FF);
+	if(biased == 0 && significand == 0)
+		return text + "0.0";
+	
+	char digits[32];
+	int length, k;
+	if(biased)
+		grisu2(significand + hidden, biased - 1075, hidden, digits, length, k);
+	else
+		grisu2(significand, -1074, hidden, digits, length, k);
+	appendDecimal(text, digits, length, k);
+	return text;
+}
+
+std::string formatFloat(float value)
+{
+	if(std::isnan(value))
+		return "NaN";
+	
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	std::string text = bits >> 31 ? "-" : "";
+	if(std::isinf(value))
+		return text + "Infinity";
+	
+	const std::uint64_t hidden = 1ULL << 23;
+	std::uint64_t significand = bits & (hidden - 1);
+	int biased = static_cast<int>((bits >> 23) & 0xFF);
+	if(biased == 0 && significand == 0)
+		return text + "0.0";
+	
+	char digits[32];
+	int length, k;
+	if(biased)
+		grisu2(significand + hidden, biased - 150, hidden, digits, length, k);
+	else
+		grisu2(significand, -149, hidden, digits, length, k);
+	appendDecimal(text, digits, length, k);
+	return text;
+}
+
+std::string javaIntLiteral(std::int32_t value)
+{
+	return std::to_string(value);
+}
+
+std::string javaLongLiteral(std::int64_t value)
+{
+	return std::to_string(value) + "L";
+}
+
+std::string javaFloatLiteral(float value)
+{
+	if(std::isnan(value))
+		return "Float.NaN";
+	if(std::isinf(value))
+		return value > 0 ? "Float.POSITIVE_INFINITY" : "Float.NEGATIVE_INFINITY";
+	return formatFloat(value) + "f";
+}
+
+std::string javaDoubleLiteral(double value)
+{
+	if(std::isnan(value))
+		return "Double.NaN";
+	if(std::isinf(value))
+		return value > 0 ? "Double.POSITIVE_INFINITY" : "Double.NEGATIVE_INFINITY";
+	return formatDouble(value);
+}
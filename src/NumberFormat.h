@@ -0,0 +1,44 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+#include <cstdint>
+#include <string>
+
+// the shortest text reading back as the same value (Grisu2,
+// https://florian.loitsch.com/publications), in the style of Java's
+// Double.toString: "0.1", "1.0E10", "-0.0", "NaN", "-Infinity"
+std::string formatDouble(double value);
+std::string formatFloat(float value);
+
+// Java source literals: "7", "7L", "1.5f", "Double.NaN",
+// "Float.NEGATIVE_INFINITY"...
+std::string javaIntLiteral(std::int32_t value);
+std::string javaLongLiteral(std::int64_t value);
+std::string javaFloatLiteral(float value);
+std::string javaDoubleLiteral(double value);
+
+#endif
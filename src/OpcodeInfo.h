@@ -0,0 +1,358 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef OPCODEINFO_H
+#define OPCODEINFO_H
+
+#include "opcodes.h"
+#include <cstdint>
+
+// what the JVM specification says of each opcode, for everything that walks
+// bytecode: lengths, stack checks, listings, control flow; and whether the
+// decoder in MethodOutput.cpp handles it, to be kept in step with its switch
+
+enum OperandKind
+{
+	OPERAND_NONE,
+	OPERAND_BYTE, // signed byte (bipush)
+	OPERAND_SHORT, // signed short (sipush)
+	OPERAND_LOCAL, // local variable index, a byte
+	OPERAND_CONSTANT1, // constant pool index, a byte (ldc)
+	OPERAND_CONSTANT2, // constant pool index, a short
+	OPERAND_BRANCH2, // signed offset from the opcode, a short
+	OPERAND_BRANCH4, // same, an int
+	OPERAND_IINC, // local index, signed byte
+	OPERAND_INVOKEINTERFACE, // constant index, count, 0
+	OPERAND_INVOKEDYNAMIC, // constant index, 0, 0
+	OPERAND_ARRAY_TYPE, // T_BOOLEAN to T_LONG
+	OPERAND_MULTIANEWARRAY, // constant index, dimensions
+	OPERAND_SWITCH, // padding to 4 bytes, then the table
+	OPERAND_WIDE // an opcode, then wider operands
+};
+
+enum FlowKind
+{
+	FLOW_NEXT, // falls through to the next instruction
+	FLOW_BRANCH, // conditional jump
+	FLOW_GOTO,
+	FLOW_SWITCH,
+	FLOW_RETURN,
+	FLOW_THROW,
+	FLOW_JSR,
+	FLOW_RET
+};
+
+// the stack effect depends on a descriptor, or on the category of the values
+const std::int8_t STACK_VARIABLE = -1;
+
+struct OpcodeInfo
+{
+	const char * mnemonic; // nullptr for the undefined opcodes
+	std::uint8_t length; // 0 for the switches and wide, see instructionLength()
+	std::uint8_t operands; // OperandKind
+	std::int8_t pops; // values, whatever their category, or STACK_VARIABLE
+	std::int8_t pushes;
+	std::uint8_t category; // of the values pushed: 2 for long and double, 0 when it depends on a descriptor or on the values
+	std::uint8_t flow; // FlowKind
+	bool decompiled; // turned into Java by generate(), the others only leave a comment or nothing
+};
+
+constexpr OpcodeInfo OPCODE_INFO[256] = {
+	{"nop", 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, true}, // 0x00
+	{"aconst_null", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x01
+	{"iconst_m1", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x02
+	{"iconst_0", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x03
+	{"iconst_1", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x04
+	{"iconst_2", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x05
+	{"iconst_3", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x06
+	{"iconst_4", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x07
+	{"iconst_5", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x08
+	{"lconst_0", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x09
+	{"lconst_1", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x0a
+	{"fconst_0", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x0b
+	{"fconst_1", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x0c
+	{"fconst_2", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x0d
+	{"dconst_0", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x0e
+	{"dconst_1", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x0f
+	{"bipush", 2, OPERAND_BYTE, 0, 1, 1, FLOW_NEXT, true}, // 0x10
+	{"sipush", 3, OPERAND_SHORT, 0, 1, 1, FLOW_NEXT, true}, // 0x11
+	{"ldc", 2, OPERAND_CONSTANT1, 0, 1, 1, FLOW_NEXT, true}, // 0x12
+	{"ldc_w", 3, OPERAND_CONSTANT2, 0, 1, 1, FLOW_NEXT, true}, // 0x13
+	{"ldc2_w", 3, OPERAND_CONSTANT2, 0, 1, 2, FLOW_NEXT, true}, // 0x14
+	{"iload", 2, OPERAND_LOCAL, 0, 1, 1, FLOW_NEXT, true}, // 0x15
+	{"lload", 2, OPERAND_LOCAL, 0, 1, 2, FLOW_NEXT, true}, // 0x16
+	{"fload", 2, OPERAND_LOCAL, 0, 1, 1, FLOW_NEXT, true}, // 0x17
+	{"dload", 2, OPERAND_LOCAL, 0, 1, 2, FLOW_NEXT, true}, // 0x18
+	{"aload", 2, OPERAND_LOCAL, 0, 1, 1, FLOW_NEXT, true}, // 0x19
+	{"iload_0", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x1a
+	{"iload_1", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x1b
+	{"iload_2", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x1c
+	{"iload_3", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x1d
+	{"lload_0", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x1e
+	{"lload_1", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x1f
+	{"lload_2", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x20
+	{"lload_3", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x21
+	{"fload_0", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x22
+	{"fload_1", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x23
+	{"fload_2", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x24
+	{"fload_3", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x25
+	{"dload_0", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x26
+	{"dload_1", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x27
+	{"dload_2", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x28
+	{"dload_3", 1, OPERAND_NONE, 0, 1, 2, FLOW_NEXT, true}, // 0x29
+	{"aload_0", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x2a
+	{"aload_1", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x2b
+	{"aload_2", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x2c
+	{"aload_3", 1, OPERAND_NONE, 0, 1, 1, FLOW_NEXT, true}, // 0x2d
+	{"iaload", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x2e
+	{"laload", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x2f
+	{"faload", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x30
+	{"daload", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x31
+	{"aaload", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x32
+	{"baload", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x33
+	{"caload", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x34
+	{"saload", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x35
+	{"istore", 2, OPERAND_LOCAL, 1, 0, 1, FLOW_NEXT, true}, // 0x36
+	{"lstore", 2, OPERAND_LOCAL, 1, 0, 1, FLOW_NEXT, true}, // 0x37
+	{"fstore", 2, OPERAND_LOCAL, 1, 0, 1, FLOW_NEXT, true}, // 0x38
+	{"dstore", 2, OPERAND_LOCAL, 1, 0, 1, FLOW_NEXT, true}, // 0x39
+	{"astore", 2, OPERAND_LOCAL, 1, 0, 1, FLOW_NEXT, true}, // 0x3a
+	{"istore_0", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x3b
+	{"istore_1", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x3c
+	{"istore_2", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x3d
+	{"istore_3", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x3e
+	{"lstore_0", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x3f
+	{"lstore_1", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x40
+	{"lstore_2", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x41
+	{"lstore_3", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x42
+	{"fstore_0", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x43
+	{"fstore_1", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x44
+	{"fstore_2", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x45
+	{"fstore_3", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x46
+	{"dstore_0", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x47
+	{"dstore_1", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x48
+	{"dstore_2", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x49
+	{"dstore_3", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x4a
+	{"astore_0", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x4b
+	{"astore_1", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x4c
+	{"astore_2", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x4d
+	{"astore_3", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x4e
+	{"iastore", 1, OPERAND_NONE, 3, 0, 1, FLOW_NEXT, true}, // 0x4f
+	{"lastore", 1, OPERAND_NONE, 3, 0, 1, FLOW_NEXT, true}, // 0x50
+	{"fastore", 1, OPERAND_NONE, 3, 0, 1, FLOW_NEXT, true}, // 0x51
+	{"dastore", 1, OPERAND_NONE, 3, 0, 1, FLOW_NEXT, true}, // 0x52
+	{"aastore", 1, OPERAND_NONE, 3, 0, 1, FLOW_NEXT, true}, // 0x53
+	{"bastore", 1, OPERAND_NONE, 3, 0, 1, FLOW_NEXT, true}, // 0x54
+	{"castore", 1, OPERAND_NONE, 3, 0, 1, FLOW_NEXT, true}, // 0x55
+	{"sastore", 1, OPERAND_NONE, 3, 0, 1, FLOW_NEXT, true}, // 0x56
+	{"pop", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0x57
+	{"pop2", 1, OPERAND_NONE, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0x58
+	{"dup", 1, OPERAND_NONE, 1, 2, 1, FLOW_NEXT, true}, // 0x59
+	{"dup_x1", 1, OPERAND_NONE, 2, 3, 1, FLOW_NEXT, true}, // 0x5a
+	{"dup_x2", 1, OPERAND_NONE, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0x5b
+	{"dup2", 1, OPERAND_NONE, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0x5c
+	{"dup2_x1", 1, OPERAND_NONE, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0x5d
+	{"dup2_x2", 1, OPERAND_NONE, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0x5e
+	{"swap", 1, OPERAND_NONE, 2, 2, 1, FLOW_NEXT, true}, // 0x5f
+	{"iadd", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x60
+	{"ladd", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x61
+	{"fadd", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x62
+	{"dadd", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x63
+	{"isub", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x64
+	{"lsub", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x65
+	{"fsub", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x66
+	{"dsub", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x67
+	{"imul", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x68
+	{"lmul", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x69
+	{"fmul", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x6a
+	{"dmul", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x6b
+	{"idiv", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x6c
+	{"ldiv", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x6d
+	{"fdiv", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x6e
+	{"ddiv", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x6f
+	{"irem", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x70
+	{"lrem", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x71
+	{"frem", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x72
+	{"drem", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x73
+	{"ineg", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x74
+	{"lneg", 1, OPERAND_NONE, 1, 1, 2, FLOW_NEXT, true}, // 0x75
+	{"fneg", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x76
+	{"dneg", 1, OPERAND_NONE, 1, 1, 2, FLOW_NEXT, true}, // 0x77
+	{"ishl", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x78
+	{"lshl", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x79
+	{"ishr", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x7a
+	{"lshr", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x7b
+	{"iushr", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x7c
+	{"lushr", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x7d
+	{"iand", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x7e
+	{"land", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x7f
+	{"ior", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x80
+	{"lor", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x81
+	{"ixor", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x82
+	{"lxor", 1, OPERAND_NONE, 2, 1, 2, FLOW_NEXT, true}, // 0x83
+	{"iinc", 3, OPERAND_IINC, 0, 0, 1, FLOW_NEXT, true}, // 0x84
+	{"i2l", 1, OPERAND_NONE, 1, 1, 2, FLOW_NEXT, true}, // 0x85
+	{"i2f", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x86
+	{"i2d", 1, OPERAND_NONE, 1, 1, 2, FLOW_NEXT, true}, // 0x87
+	{"l2i", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x88
+	{"l2f", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x89
+	{"l2d", 1, OPERAND_NONE, 1, 1, 2, FLOW_NEXT, true}, // 0x8a
+	{"f2i", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x8b
+	{"f2l", 1, OPERAND_NONE, 1, 1, 2, FLOW_NEXT, true}, // 0x8c
+	{"f2d", 1, OPERAND_NONE, 1, 1, 2, FLOW_NEXT, true}, // 0x8d
+	{"d2i", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x8e
+	{"d2l", 1, OPERAND_NONE, 1, 1, 2, FLOW_NEXT, true}, // 0x8f
+	{"d2f", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x90
+	{"i2b", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x91
+	{"i2c", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x92
+	{"i2s", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0x93
+	{"lcmp", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x94
+	{"fcmpl", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x95
+	{"fcmpg", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x96
+	{"dcmpl", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x97
+	{"dcmpg", 1, OPERAND_NONE, 2, 1, 1, FLOW_NEXT, true}, // 0x98
+	{"ifeq", 3, OPERAND_BRANCH2, 1, 0, 1, FLOW_BRANCH, true}, // 0x99
+	{"ifne", 3, OPERAND_BRANCH2, 1, 0, 1, FLOW_BRANCH, true}, // 0x9a
+	{"iflt", 3, OPERAND_BRANCH2, 1, 0, 1, FLOW_BRANCH, true}, // 0x9b
+	{"ifge", 3, OPERAND_BRANCH2, 1, 0, 1, FLOW_BRANCH, true}, // 0x9c
+	{"ifgt", 3, OPERAND_BRANCH2, 1, 0, 1, FLOW_BRANCH, true}, // 0x9d
+	{"ifle", 3, OPERAND_BRANCH2, 1, 0, 1, FLOW_BRANCH, true}, // 0x9e
+	{"if_icmpeq", 3, OPERAND_BRANCH2, 2, 0, 1, FLOW_BRANCH, true}, // 0x9f
+	{"if_icmpne", 3, OPERAND_BRANCH2, 2, 0, 1, FLOW_BRANCH, true}, // 0xa0
+	{"if_icmplt", 3, OPERAND_BRANCH2, 2, 0, 1, FLOW_BRANCH, true}, // 0xa1
+	{"if_icmpge", 3, OPERAND_BRANCH2, 2, 0, 1, FLOW_BRANCH, true}, // 0xa2
+	{"if_icmpgt", 3, OPERAND_BRANCH2, 2, 0, 1, FLOW_BRANCH, true}, // 0xa3
+	{"if_icmple", 3, OPERAND_BRANCH2, 2, 0, 1, FLOW_BRANCH, true}, // 0xa4
+	{"if_acmpeq", 3, OPERAND_BRANCH2, 2, 0, 1, FLOW_BRANCH, true}, // 0xa5
+	{"if_acmpne", 3, OPERAND_BRANCH2, 2, 0, 1, FLOW_BRANCH, true}, // 0xa6
+	{"goto", 3, OPERAND_BRANCH2, 0, 0, 1, FLOW_GOTO, true}, // 0xa7
+	{"jsr", 3, OPERAND_BRANCH2, 0, 1, 1, FLOW_JSR, false}, // 0xa8
+	{"ret", 2, OPERAND_LOCAL, 0, 0, 1, FLOW_RET, false}, // 0xa9
+	{"tableswitch", 0, OPERAND_SWITCH, 1, 0, 1, FLOW_SWITCH, false}, // 0xaa
+	{"lookupswitch", 0, OPERAND_SWITCH, 1, 0, 1, FLOW_SWITCH, false}, // 0xab
+	{"ireturn", 1, OPERAND_NONE, 1, 0, 1, FLOW_RETURN, true}, // 0xac
+	{"lreturn", 1, OPERAND_NONE, 1, 0, 1, FLOW_RETURN, true}, // 0xad
+	{"freturn", 1, OPERAND_NONE, 1, 0, 1, FLOW_RETURN, true}, // 0xae
+	{"dreturn", 1, OPERAND_NONE, 1, 0, 1, FLOW_RETURN, true}, // 0xaf
+	{"areturn", 1, OPERAND_NONE, 1, 0, 1, FLOW_RETURN, true}, // 0xb0
+	{"return", 1, OPERAND_NONE, 0, 0, 1, FLOW_RETURN, true}, // 0xb1
+	{"getstatic", 3, OPERAND_CONSTANT2, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xb2
+	{"putstatic", 3, OPERAND_CONSTANT2, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xb3
+	{"getfield", 3, OPERAND_CONSTANT2, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xb4
+	{"putfield", 3, OPERAND_CONSTANT2, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xb5
+	{"invokevirtual", 3, OPERAND_CONSTANT2, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xb6
+	{"invokespecial", 3, OPERAND_CONSTANT2, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xb7
+	{"invokestatic", 3, OPERAND_CONSTANT2, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xb8
+	{"invokeinterface", 5, OPERAND_INVOKEINTERFACE, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xb9
+	{"invokedynamic", 5, OPERAND_INVOKEDYNAMIC, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, true}, // 0xba
+	{"new", 3, OPERAND_CONSTANT2, 0, 1, 1, FLOW_NEXT, true}, // 0xbb
+	{"newarray", 2, OPERAND_ARRAY_TYPE, 1, 1, 1, FLOW_NEXT, true}, // 0xbc
+	{"anewarray", 3, OPERAND_CONSTANT2, 1, 1, 1, FLOW_NEXT, true}, // 0xbd
+	{"arraylength", 1, OPERAND_NONE, 1, 1, 1, FLOW_NEXT, true}, // 0xbe
+	{"athrow", 1, OPERAND_NONE, 1, 0, 1, FLOW_THROW, false}, // 0xbf
+	{"checkcast", 3, OPERAND_CONSTANT2, 1, 1, 1, FLOW_NEXT, false}, // 0xc0
+	{"instanceof", 3, OPERAND_CONSTANT2, 1, 1, 1, FLOW_NEXT, true}, // 0xc1
+	{"monitorenter", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0xc2
+	{"monitorexit", 1, OPERAND_NONE, 1, 0, 1, FLOW_NEXT, true}, // 0xc3
+	{"wide", 0, OPERAND_WIDE, STACK_VARIABLE, STACK_VARIABLE, 0, FLOW_NEXT, false}, // 0xc4
+	{"multianewarray", 4, OPERAND_MULTIANEWARRAY, STACK_VARIABLE, 1, 1, FLOW_NEXT, true}, // 0xc5
+	{"ifnull", 3, OPERAND_BRANCH2, 1, 0, 1, FLOW_BRANCH, true}, // 0xc6
+	{"ifnonnull", 3, OPERAND_BRANCH2, 1, 0, 1, FLOW_BRANCH, true}, // 0xc7
+	{"goto_w", 5, OPERAND_BRANCH4, 0, 0, 1, FLOW_GOTO, false}, // 0xc8
+	{"jsr_w", 5, OPERAND_BRANCH4, 0, 1, 1, FLOW_JSR, false}, // 0xc9
+	{"breakpoint", 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xca
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xcb
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xcc
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xcd
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xce
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xcf
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd0
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd1
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd2
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd3
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd4
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd5
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd6
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd7
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd8
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xd9
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xda
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xdb
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xdc
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xdd
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xde
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xdf
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe0
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe1
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe2
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe3
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe4
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe5
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe6
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe7
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe8
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xe9
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xea
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xeb
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xec
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xed
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xee
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xef
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf0
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf1
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf2
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf3
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf4
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf5
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf6
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf7
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf8
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xf9
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xfa
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xfb
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xfc
+	{nullptr, 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xfd
+	{"impdep1", 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}, // 0xfe
+	{"impdep2", 1, OPERAND_NONE, 0, 0, 1, FLOW_NEXT, false}  // 0xff
+};
+
+constexpr const OpcodeInfo & opcodeInfo(unsigned char opcode)
+{
+	return OPCODE_INFO[opcode];
+}
+
+constexpr bool sameMnemonic(const char * a, const char * b)
+{
+	return *a == *b && (*a == '\0' || sameMnemonic(a + 1, b + 1));
+}
+
+// the table follows opcodes.h
+static_assert(sameMnemonic(opcodeInfo(OP_ldc).mnemonic, "ldc"), "OPCODE_INFO is out of order");
+static_assert(sameMnemonic(opcodeInfo(OP_iinc).mnemonic, "iinc"), "OPCODE_INFO is out of order");
+static_assert(sameMnemonic(opcodeInfo(OP_lookupswitch).mnemonic, "lookupswitch"), "OPCODE_INFO is out of order");
+static_assert(sameMnemonic(opcodeInfo(OP_invokedynamic).mnemonic, "invokedynamic"), "OPCODE_INFO is out of order");
+static_assert(sameMnemonic(opcodeInfo(OP_breakpoint).mnemonic, "breakpoint"), "OPCODE_INFO is out of order");
+static_assert(sameMnemonic(opcodeInfo(OP_impdep2).mnemonic, "impdep2"), "OPCODE_INFO is out of order");
+
+#endif
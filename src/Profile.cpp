@@ -0,0 +1,472 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Profile.h"
+#include "CPinfo.h"
+#include "Diagnostics.h"
+#include "FileUtils.h"
+#include "Helpers.h"
+#include "JarReader.h"
+#include "Json.h"
+#include "MethodOutput.h"
+#include "OpcodeInfo.h"
+#include "opcodes.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+// bounds checked big-endian reads over a class file
+class Reader
+{
+public:
+	Reader(const std::uint8_t * data, std::size_t length)
+		: data(data), length(length)
+	{
+	}
+	
+	bool good() const
+	{
+		return !overrun;
+	}
+	
+	std::size_t position() const
+	{
+		return pos;
+	}
+	
+	std::uint8_t u1()
+	{
+		if(!need(1))
+			return 0;
+		return data[pos++];
+	}
+	
+	std::uint16_t u2()
+	{
+		if(!need(2))
+			return 0;
+		std::uint16_t value = (data[pos] << 8) | data[pos + 1];
+		pos += 2;
+		return value;
+	}
+	
+	std::uint32_t u4()
+	{
+		if(!need(4))
+			return 0;
+		std::uint32_t value = (std::uint32_t(data[pos]) << 24) | (data[pos + 1] << 16) | (data[pos + 2] << 8) | data[pos + 3];
+		pos += 4;
+		return value;
+	}
+	
+	void skip(std::size_t n)
+	{
+		if(need(n))
+			pos += n;
+	}
+
+private:
+	bool need(std::size_t n)
+	{
+		if(overrun || n > length - pos)
+			overrun = true;
+		return !overrun;
+	}
+	
+	const std::uint8_t * data;
+	std::size_t length;
+	std::size_t pos = 0;
+	bool overrun = false;
+};
+
+int bucket(std::uint32_t value)
+{
+	int i = 0;
+	for(;value > 1 && i < Profile::BUCKETS - 1;value >>= 1)
+		i++;
+	return i;
+}
+
+const char * tagName(int tag)
+{
+	switch(tag)
+	{
+		case CONSTANT_Utf8: return "Utf8";
+		case CONSTANT_Integer: return "Integer";
+		case CONSTANT_Float: return "Float";
+		case CONSTANT_Long: return "Long";
+		case CONSTANT_Double: return "Double";
+		case CONSTANT_Class: return "Class";
+		case CONSTANT_String: return "String";
+		case CONSTANT_Fieldref: return "Fieldref";
+		case CONSTANT_Methodref: return "Methodref";
+		case CONSTANT_InterfaceMethodref: return "InterfaceMethodref";
+		case CONSTANT_NameAndType: return "NameAndType";
+		case CONSTANT_MethodHandle: return "MethodHandle";
+		case CONSTANT_MethodType: return "MethodType";
+		case CONSTANT_InvokeDynamic: return "InvokeDynamic";
+	}
+	return "unknown";
+}
+
+std::string bucketLabel(int i)
+{
+	if(i == 0)
+		return "0-1";
+	return std::to_string(1u << i) + "-" + std::to_string((2u << i) - 1);
+}
+
+void printCounts(std::ostream & out, const char * title, const std::vector<std::pair<std::string, std::uint64_t>> & counts)
+{
+	if(counts.empty())
+		return;
+	
+	std::uint64_t total = 0;
+	for(const auto & count : counts)
+		total += count.second;
+	
+	out << "\n" << title << ":\n";
+	char line[128];
+	for(const auto & count : counts)
+	{
+		std::snprintf(line, sizeof(line), "  %-24s %14llu %7.2f%%\n", count.first.c_str(),
+			static_cast<unsigned long long>(count.second), 100.0 * count.second / total);
+		out << line;
+	}
+}
+
+// non-zero entries, in decreasing order if sorted
+std::vector<std::pair<std::string, std::uint64_t>> opcodeCounts(const std::uint64_t * counts, bool sorted)
+{
+	std::vector<std::pair<std::string, std::uint64_t>> result;
+	std::vector<int> opcodes;
+	for(int i = 0;i < 256;i++)
+	{
+		if(counts[i])
+			opcodes.push_back(i);
+	}
+	if(sorted)
+		std::stable_sort(opcodes.begin(), opcodes.end(), [counts](int a, int b) { return counts[a] > counts[b]; });
+	for(int opcode : opcodes)
+		result.push_back(std::make_pair(opcodeName(opcode), counts[opcode]));
+	return result;
+}
+
+std::vector<std::pair<std::string, std::uint64_t>> tagCounts(const std::uint64_t * counts)
+{
+	std::vector<std::pair<std::string, std::uint64_t>> result;
+	for(int i = 0;i < 256;i++)
+	{
+		if(counts[i])
+			result.push_back(std::make_pair(tagName(i), counts[i]));
+	}
+	return result;
+}
+
+std::vector<std::pair<std::string, std::uint64_t>> bucketCounts(const std::uint64_t * counts)
+{
+	std::vector<std::pair<std::string, std::uint64_t>> result;
+	for(int i = 0;i < Profile::BUCKETS;i++)
+	{
+		if(counts[i])
+			result.push_back(std::make_pair(bucketLabel(i), counts[i]));
+	}
+	return result;
+}
+
+void writeJsonCounts(std::ostream & out, const char * name, const std::vector<std::pair<std::string, std::uint64_t>> & counts)
+{
+	out << ",\"" << name << "\":{";
+	for(std::size_t i = 0;i < counts.size();i++)
+	{
+		out << (i ? "," : "");
+		writeJsonString(out, counts[i].first);
+		out << ":" << counts[i].second;
+	}
+	out << "}";
+}
+
+}
+
+bool Profile::addClass(const std::uint8_t * data, std::size_t length)
+{
+	classes++;
+	bytes += length;
+	Reader reader(data, length);
+	
+	if(reader.u4() != 0xcafebabe)
+	{
+		invalidClasses++;
+		return false;
+	}
+	reader.skip(4); // version
+	
+	std::uint16_t constantCount = reader.u2();
+	pool.assign(constantCount, Constant());
+	for(std::uint16_t i = 1;i < constantCount && reader.good();i++)
+	{
+		Constant & constant = pool[i];
+		constant.tag = reader.u1();
+		constantTags[constant.tag]++;
+		switch(constant.tag)
+		{
+			case CONSTANT_Utf8:
+				constant.length = reader.u2();
+				constant.offset = static_cast<std::uint32_t>(reader.position());
+				reader.skip(constant.length);
+				break;
+			case CONSTANT_Class:
+			case CONSTANT_String:
+			case CONSTANT_MethodType:
+				reader.skip(2);
+				break;
+			case CONSTANT_MethodHandle:
+				reader.skip(3);
+				break;
+			case CONSTANT_Integer:
+			case CONSTANT_Float:
+			case CONSTANT_Fieldref:
+			case CONSTANT_Methodref:
+			case CONSTANT_InterfaceMethodref:
+			case CONSTANT_NameAndType:
+			case CONSTANT_InvokeDynamic:
+				reader.skip(4);
+				break;
+			case CONSTANT_Long:
+			case CONSTANT_Double:
+				reader.skip(8);
+				i++; // two entries
+				break;
+			default:
+				invalidClasses++;
+				return false;
+		}
+	}
+	
+	reader.skip(6); // access flags, this and super
+	reader.skip(2 * reader.u2()); // interfaces
+	
+	auto attributeName = [this, data](std::uint16_t index) {
+		if(index >= pool.size() || pool[index].tag != CONSTANT_Utf8)
+			return std::string("?");
+		return std::string(reinterpret_cast<const char *>(data) + pool[index].offset, pool[index].length);
+	};
+	
+	for(int members = 0;members < 2 && reader.good();members++) // fields, then methods
+	{
+		std::uint16_t count = reader.u2();
+		if(members == 1)
+			methods += count;
+		for(std::uint16_t i = 0;i < count && reader.good();i++)
+		{
+			reader.skip(6); // access flags, name and descriptor
+			std::uint16_t attributeCount = reader.u2();
+			for(std::uint16_t j = 0;j < attributeCount && reader.good();j++)
+			{
+				std::string name = attributeName(reader.u2());
+				std::uint32_t attributeLength = reader.u4();
+				attributes[name]++;
+				if(name != "Code" || attributeLength < 12 || attributeLength > length - reader.position())
+				{
+					reader.skip(attributeLength);
+					continue;
+				}
+				
+				std::size_t end = reader.position() + attributeLength;
+				maxStack[bucket(reader.u2())]++;
+				maxLocals[bucket(reader.u2())]++;
+				std::uint32_t codeLength = reader.u4();
+				if(codeLength > end - reader.position())
+				{
+					invalidClasses++;
+					return false;
+				}
+				codeLengths[bucket(codeLength)]++;
+				
+				const unsigned char * code = data + reader.position();
+				for(std::size_t pc = 0;pc < codeLength;)
+				{
+					std::size_t size = instructionLength(code, pc, codeLength);
+					if(size == 0)
+						break;
+					
+					unsigned char opcode = code[pc];
+					opcodes[opcode]++;
+					instructionLengths[std::min<std::size_t>(size, 15)]++;
+					instructions++;
+					if(!opcodeInfo(opcode).decompiled)
+					{
+						unsupportedOpcodes[opcode]++;
+					}
+					else if(opcode == OP_ldc || opcode == OP_ldc_w || opcode == OP_ldc2_w)
+					{
+						std::uint16_t index = opcode == OP_ldc ? code[pc + 1] : (code[pc + 1] << 8) | code[pc + 2];
+						std::uint8_t tag = index < pool.size() ? pool[index].tag : 0;
+						if(!constantLoadDecompiled(tag))
+							unsupportedConstants[tag]++;
+					}
+					pc += size;
+				}
+				reader.skip(codeLength);
+				
+				reader.skip(8 * reader.u2()); // exception table
+				std::uint16_t codeAttributes = reader.u2();
+				for(std::uint16_t k = 0;k < codeAttributes && reader.good();k++)
+				{
+					attributes[attributeName(reader.u2())]++;
+					reader.skip(reader.u4());
+				}
+			}
+		}
+	}
+	
+	std::uint16_t attributeCount = reader.u2();
+	for(std::uint16_t i = 0;i < attributeCount && reader.good();i++)
+	{
+		attributes[attributeName(reader.u2())]++;
+		reader.skip(reader.u4());
+	}
+	
+	if(!reader.good())
+	{
+		invalidClasses++;
+		return false;
+	}
+	return true;
+}
+
+std::uint64_t Profile::addInputs(const std::vector<std::string> & inputs)
+{
+	std::uint64_t failed = 0;
+	
+	auto addJar = [this, &failed](const std::string & path) {
+		JarReader jar(path);
+		if(!jar.isOpen())
+		{
+			DIAG(DIAG_ERROR, "can't open " << path << " as a jar");
+			failed++;
+			return;
+		}
+		
+		JarReader::Entry entry;
+		while(jar.nextEntry(entry))
+		{
+			if(!endsWith(entry.name, ".class"))
+				continue;
+			if(!jar.read(entry, buffer))
+			{
+				DIAG(DIAG_ERROR, "can't inflate " << entry.name << " from " << path);
+				failed++;
+				continue;
+			}
+			addClass(buffer.data(), buffer.size());
+		}
+	};
+	
+	auto addFile = [this, &failed](const std::string & path) {
+		if(!readFile(path, buffer))
+		{
+			DIAG(DIAG_ERROR, "can't read " << path);
+			failed++;
+			return;
+		}
+		addClass(buffer.data(), buffer.size());
+	};
+	
+	for(const std::string & input : inputs)
+	{
+		if(isDirectory(input))
+		{
+			for(const std::string & file : listFiles(input))
+			{
+				if(endsWith(file, ".class"))
+					addFile(input + "/" + file);
+				else if(endsWith(file, ".jar"))
+					addJar(input + "/" + file);
+			}
+		}
+		else if(endsWith(input, ".jar"))
+		{
+			addJar(input);
+		}
+		else
+		{
+			addFile(input);
+		}
+	}
+	return failed;
+}
+
+void Profile::print(std::ostream & out) const
+{
+	out << "classes: " << classes << " (" << invalidClasses << " invalid), " << bytes << " bytes\n"
+	    << "methods: " << methods << ", instructions: " << instructions << "\n";
+	
+	printCounts(out, "opcodes", opcodeCounts(opcodes, true));
+	
+	std::vector<std::pair<std::string, std::uint64_t>> lengths;
+	for(int i = 1;i < 16;i++)
+	{
+		if(instructionLengths[i])
+			lengths.push_back(std::make_pair(std::to_string(i) + (i == 15 ? "+" : "") + " bytes", instructionLengths[i]));
+	}
+	printCounts(out, "instruction lengths", lengths);
+	printCounts(out, "code lengths (bytes)", bucketCounts(codeLengths));
+	printCounts(out, "max_stack", bucketCounts(maxStack));
+	printCounts(out, "max_locals", bucketCounts(maxLocals));
+	printCounts(out, "constant pool tags", tagCounts(constantTags));
+	
+	std::vector<std::pair<std::string, std::uint64_t>> names(attributes.begin(), attributes.end());
+	std::stable_sort(names.begin(), names.end(), [](const std::pair<std::string, std::uint64_t> & a, const std::pair<std::string, std::uint64_t> & b) { return a.second > b.second; });
+	printCounts(out, "attributes", names);
+	
+	printCounts(out, "opcodes not decompiled", opcodeCounts(unsupportedOpcodes, true));
+	printCounts(out, "ldc of constants not decompiled", tagCounts(unsupportedConstants));
+}
+
+void Profile::writeJson(std::ostream & out) const
+{
+	out << "{\"classes\":" << classes << ",\"invalid_classes\":" << invalidClasses << ",\"bytes\":" << bytes
+	    << ",\"methods\":" << methods << ",\"instructions\":" << instructions;
+	
+	writeJsonCounts(out, "opcodes", opcodeCounts(opcodes, false));
+	std::vector<std::pair<std::string, std::uint64_t>> lengths;
+	for(int i = 1;i < 16;i++)
+	{
+		if(instructionLengths[i])
+			lengths.push_back(std::make_pair(std::to_string(i), instructionLengths[i]));
+	}
+	writeJsonCounts(out, "instruction_lengths", lengths);
+	writeJsonCounts(out, "code_lengths", bucketCounts(codeLengths));
+	writeJsonCounts(out, "max_stack", bucketCounts(maxStack));
+	writeJsonCounts(out, "max_locals", bucketCounts(maxLocals));
+	writeJsonCounts(out, "constant_tags", tagCounts(constantTags));
+	writeJsonCounts(out, "attributes", std::vector<std::pair<std::string, std::uint64_t>>(attributes.begin(), attributes.end()));
+	writeJsonCounts(out, "unsupported_opcodes", opcodeCounts(unsupportedOpcodes, false));
+	writeJsonCounts(out, "unsupported_constants", tagCounts(unsupportedConstants));
+	out << "}\n";
+}
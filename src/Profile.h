@@ -0,0 +1,79 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// what a corpus of classes is made of, to decide which paths of the
+// decompiler matter: only the class file structure and the bytecode are
+// walked, nothing is decompiled
+struct Profile
+{
+	static const int BUCKETS = 17; // powers of two, up to 65535
+	
+	std::uint64_t classes = 0;
+	std::uint64_t invalidClasses = 0;
+	std::uint64_t bytes = 0;
+	std::uint64_t methods = 0;
+	std::uint64_t instructions = 0;
+	std::uint64_t opcodes[256] = {};
+	std::uint64_t instructionLengths[16] = {}; // the last one for 15 and more
+	std::uint64_t codeLengths[BUCKETS] = {}; // of the methods, in bytes
+	std::uint64_t maxStack[BUCKETS] = {};
+	std::uint64_t maxLocals[BUCKETS] = {};
+	std::uint64_t constantTags[256] = {};
+	std::map<std::string, std::uint64_t> attributes;
+	std::uint64_t unsupportedOpcodes[256] = {}; // see OpcodeInfo::decompiled
+	std::uint64_t unsupportedConstants[256] = {}; // ldc of these tags
+	
+	// returns false if the class is malformed, in which case only what was
+	// read before the error is counted
+	bool addClass(const std::uint8_t * data, std::size_t length);
+	// class files, jars and directories of them; returns the inputs which
+	// couldn't be read
+	std::uint64_t addInputs(const std::vector<std::string> & inputs);
+	
+	void print(std::ostream & out) const;
+	void writeJson(std::ostream & out) const;
+
+private:
+	struct Constant
+	{
+		std::uint8_t tag;
+		std::uint32_t offset; // of the bytes of a Utf8
+		std::uint16_t length;
+	};
+	
+	std::vector<Constant> pool; // reused from one class to the next
+	std::vector<std::uint8_t> buffer;
+};
+
+#endif
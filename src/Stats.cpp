@@ -0,0 +1,230 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Stats.h"
+#include "Helpers.h"
+#include "Json.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+thread_local ClassStats * currentClassStats = nullptr;
+thread_local int currentStatsStage = STAGE_COUNT;
+thread_local StatsTimer * StatsTimer::current = nullptr;
+
+static std::atomic<bool> enabled(false);
+static std::mutex totalsMutex;
+static RunStats totals;
+
+static const std::size_t LARGEST_CLASSES = 10;
+
+static const char * stageNames[STAGE_COUNT] = {
+	"read",
+	"constant_pool",
+	"members",
+	"decode",
+	"control_flow",
+	"emit",
+	"write"
+};
+
+static const char * counterNames[COUNTER_COUNT] = {
+	"bytes",
+	"constants",
+	"methods",
+	"instructions",
+	"stubbed_methods",
+	"allocations",
+	"allocated_bytes"
+};
+
+void setStatsEnabled(bool enable)
+{
+	enabled = enable;
+}
+
+bool statsEnabled()
+{
+#ifdef JDQ_NO_STATS
+	return false;
+#else
+	return enabled;
+#endif
+}
+
+const char * stageName(int stage)
+{
+	return stageNames[stage];
+}
+
+const char * counterName(int counter)
+{
+	return counterNames[counter];
+}
+
+void addClassStats(const ClassStats & stats, const std::string & name)
+{
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	totals.classes++;
+	for(int i = 0;i < STAGE_COUNT;i++)
+	{
+		totals.stageNanos[i] += stats.stageNanos[i];
+		totals.stageAllocations[i] += stats.stageAllocations[i];
+		totals.stageAllocatedBytes[i] += stats.stageAllocatedBytes[i];
+		totals.stagePeakBytes[i] = std::max(totals.stagePeakBytes[i], stats.stagePeakBytes[i]);
+	}
+	for(int i = 0;i < COUNTER_COUNT;i++)
+		totals.counters[i] += stats.counters[i];
+	for(int i = 0;i < 256;i++)
+		totals.opcodes[i] += stats.opcodes[i];
+	
+	auto & largest = totals.largestClasses;
+	if(stats.peakBytes > 0 && (largest.size() < LARGEST_CLASSES || stats.peakBytes > largest.back().first))
+	{
+		auto entry = std::make_pair(stats.peakBytes, name);
+		largest.insert(std::upper_bound(largest.begin(), largest.end(), entry, [](const std::pair<std::uint64_t, std::string> & a, const std::pair<std::uint64_t, std::string> & b) {
+			return a.first > b.first;
+		}), entry);
+		if(largest.size() > LARGEST_CLASSES)
+			largest.pop_back();
+	}
+}
+
+RunStats runStats()
+{
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	return totals;
+}
+
+void printStats(std::ostream & out, const RunStats & stats, const std::map<std::string, std::uint64_t> & extra)
+{
+	char line[128];
+	std::uint64_t totalNanos = 0;
+	for(int i = 0;i < STAGE_COUNT;i++)
+		totalNanos += stats.stageNanos[i];
+	
+	out << "classes: " << stats.classes << "\n\n";
+	std::snprintf(line, sizeof(line), "%-16s %14s %8s %12s\n", "stage", "time (ms)", "%", "us/class");
+	out << line;
+	for(int i = 0;i < STAGE_COUNT;i++)
+	{
+		std::snprintf(line, sizeof(line), "%-16s %14.3f %7.1f%% %12.2f\n", stageNames[i],
+			stats.stageNanos[i] / 1e6,
+			totalNanos ? 100.0 * stats.stageNanos[i] / totalNanos : 0.0,
+			stats.classes ? stats.stageNanos[i] / 1e3 / stats.classes : 0.0);
+		out << line;
+	}
+	
+	bool allocations = stats.counters[COUNTER_ALLOCATIONS] > 0;
+	if(allocations)
+	{
+		out << "\n";
+		std::snprintf(line, sizeof(line), "%-16s %14s %14s %14s\n", "stage", "allocations", "bytes", "class peak");
+		out << line;
+		for(int i = 0;i < STAGE_COUNT;i++)
+		{
+			std::snprintf(line, sizeof(line), "%-16s %14llu %14llu %14llu\n", stageNames[i],
+				static_cast<unsigned long long>(stats.stageAllocations[i]),
+				static_cast<unsigned long long>(stats.stageAllocatedBytes[i]),
+				static_cast<unsigned long long>(stats.stagePeakBytes[i]));
+			out << line;
+		}
+	}
+	
+	out << "\n";
+	for(int i = 0;i < COUNTER_COUNT;i++)
+	{
+		std::snprintf(line, sizeof(line), "%-16s %14llu\n", counterNames[i], static_cast<unsigned long long>(stats.counters[i]));
+		out << line;
+	}
+	for(const auto & value : extra)
+	{
+		std::snprintf(line, sizeof(line), "%-16s %14llu\n", value.first.c_str(), static_cast<unsigned long long>(value.second));
+		out << line;
+	}
+	
+	std::vector<int> opcodes;
+	for(int i = 0;i < 256;i++)
+	{
+		if(stats.opcodes[i])
+			opcodes.push_back(i);
+	}
+	std::sort(opcodes.begin(), opcodes.end(), [&stats](int a, int b) { return stats.opcodes[a] > stats.opcodes[b]; });
+	if(opcodes.size() > 10)
+		opcodes.resize(10);
+	
+	if(!stats.largestClasses.empty())
+		out << "\nlargest classes (peak live bytes):\n";
+	for(const auto & largest : stats.largestClasses)
+		out << "  " << largest.first << " " << (largest.second.empty() ? "-" : largest.second) << "\n";
+	
+	if(!opcodes.empty())
+		out << "\nmost frequent opcodes:\n";
+	for(int opcode : opcodes)
+	{
+		std::snprintf(line, sizeof(line), "%-16s %14llu\n", opcodeName(opcode).c_str(), static_cast<unsigned long long>(stats.opcodes[opcode]));
+		out << line;
+	}
+}
+
+void writeStatsJson(std::ostream & out, const RunStats & stats, const std::map<std::string, std::uint64_t> & extra)
+{
+	out << "{\"classes\":" << stats.classes << ",\"stages_ns\":{";
+	for(int i = 0;i < STAGE_COUNT;i++)
+		out << (i ? "," : "") << "\"" << stageNames[i] << "\":" << stats.stageNanos[i];
+	
+	out << "},\"counters\":{";
+	for(int i = 0;i < COUNTER_COUNT;i++)
+		out << (i ? "," : "") << "\"" << counterNames[i] << "\":" << stats.counters[i];
+	for(const auto & value : extra)
+		out << ",\"" << value.first << "\":" << value.second;
+	
+	out << "},\"stage_allocations\":{";
+	for(int i = 0;i < STAGE_COUNT;i++)
+	{
+		out << (i ? "," : "") << "\"" << stageNames[i] << "\":{\"count\":" << stats.stageAllocations[i]
+		    << ",\"bytes\":" << stats.stageAllocatedBytes[i] << ",\"class_peak_bytes\":" << stats.stagePeakBytes[i] << "}";
+	}
+	
+	out << "},\"largest_classes\":[";
+	for(std::size_t i = 0;i < stats.largestClasses.size();i++)
+	{
+		out << (i ? "," : "") << "{\"class\":";
+		writeJsonString(out, stats.largestClasses[i].second);
+		out << ",\"peak_bytes\":" << stats.largestClasses[i].first << "}";
+	}
+	
+	out << "],\"opcodes\":{";
+	bool first = true;
+	for(int i = 0;i < 256;i++)
+	{
+		if(!stats.opcodes[i])
+			continue;
+		out << (first ? "" : ",") << "\"" << opcodeName(i) << "\":" << stats.opcodes[i];
+		first = false;
+	}
+	out << "}}\n";
+}
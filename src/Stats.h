@@ -0,0 +1,209 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// per-stage timers and counters
+// the STATS_ macros compile to nothing with -DJDQ_NO_STATS; otherwise they
+// only cost a thread local load and a branch while the statistics are off
+
+enum Stage {
+	STAGE_READ,
+	STAGE_CONSTANT_POOL,
+	STAGE_MEMBERS, // fields, methods, interfaces and attributes
+	STAGE_DECODE,
+	STAGE_CONTROL_FLOW,
+	STAGE_EMIT,
+	STAGE_WRITE,
+	STAGE_COUNT
+};
+
+enum Counter {
+	COUNTER_BYTES,
+	COUNTER_CONSTANTS,
+	COUNTER_METHODS,
+	COUNTER_INSTRUCTIONS,
+	COUNTER_STUBBED_METHODS, // methods out of budget
+	COUNTER_ALLOCATIONS,
+	COUNTER_ALLOCATED_BYTES,
+	COUNTER_COUNT
+};
+
+// the allocations are only seen when the allocation hooks are linked in
+// (src/AllocHooks.cpp, in the command line tool); memory freed by another
+// class, or outside of any, is not taken back from the live bytes
+struct ClassStats
+{
+	std::uint64_t stageNanos[STAGE_COUNT] = {};
+	std::uint64_t counters[COUNTER_COUNT] = {};
+	std::uint32_t opcodes[256] = {};
+	
+	std::uint64_t stageAllocations[STAGE_COUNT] = {};
+	std::uint64_t stageAllocatedBytes[STAGE_COUNT] = {};
+	std::uint64_t stagePeakBytes[STAGE_COUNT] = {}; // live bytes of the class
+	std::int64_t liveBytes = 0;
+	std::uint64_t peakBytes = 0;
+};
+
+struct RunStats
+{
+	std::uint64_t classes = 0;
+	std::uint64_t stageNanos[STAGE_COUNT] = {};
+	std::uint64_t counters[COUNTER_COUNT] = {};
+	std::uint64_t opcodes[256] = {};
+	
+	std::uint64_t stageAllocations[STAGE_COUNT] = {};
+	std::uint64_t stageAllocatedBytes[STAGE_COUNT] = {};
+	std::uint64_t stagePeakBytes[STAGE_COUNT] = {}; // largest of a class
+	std::vector<std::pair<std::uint64_t, std::string>> largestClasses; // peak bytes and name, largest first
+};
+
+void setStatsEnabled(bool enabled);
+bool statsEnabled();
+const char * stageName(int stage);
+const char * counterName(int counter);
+
+// adds a finished class to the totals of the run
+void addClassStats(const ClassStats & stats, const std::string & name = std::string());
+RunStats runStats();
+
+void printStats(std::ostream & out, const RunStats & stats, const std::map<std::string, std::uint64_t> & extra);
+void writeStatsJson(std::ostream & out, const RunStats & stats, const std::map<std::string, std::uint64_t> & extra);
+
+// the class being worked on by this thread, and the innermost stage timed
+extern thread_local ClassStats * currentClassStats;
+extern thread_local int currentStatsStage; // STAGE_COUNT when none
+
+inline void countAllocation(std::size_t bytes)
+{
+	ClassStats * stats = currentClassStats;
+	if(!stats)
+		return;
+	
+	stats->counters[COUNTER_ALLOCATIONS]++;
+	stats->counters[COUNTER_ALLOCATED_BYTES] += bytes;
+	stats->liveBytes += bytes;
+	std::uint64_t live = stats->liveBytes > 0 ? stats->liveBytes : 0;
+	if(live > stats->peakBytes)
+		stats->peakBytes = live;
+	
+	int stage = currentStatsStage;
+	if(stage < STAGE_COUNT)
+	{
+		stats->stageAllocations[stage]++;
+		stats->stageAllocatedBytes[stage] += bytes;
+		if(live > stats->stagePeakBytes[stage])
+			stats->stagePeakBytes[stage] = live;
+	}
+}
+
+inline void countFree(std::size_t bytes)
+{
+	if(currentClassStats)
+		currentClassStats->liveBytes -= bytes;
+}
+
+class StatsScope
+{
+public:
+	StatsScope(ClassStats * stats)
+		: previous(currentClassStats)
+	{
+		currentClassStats = stats;
+	}
+	
+	~StatsScope()
+	{
+		currentClassStats = previous;
+	}
+
+private:
+	ClassStats * previous;
+};
+
+// time spent in nested timers is only counted in the innermost one
+class StatsTimer
+{
+public:
+	StatsTimer(Stage stage)
+		: stats(currentClassStats), stage(stage)
+	{
+		if(stats)
+		{
+			parent = current;
+			current = this;
+			parentStage = currentStatsStage;
+			currentStatsStage = stage;
+			start = std::chrono::steady_clock::now();
+		}
+	}
+	
+	~StatsTimer()
+	{
+		if(stats)
+		{
+			std::uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			stats->stageNanos[stage] += elapsed;
+			if(parent && parent->stats == stats)
+				stats->stageNanos[parent->stage] -= elapsed;
+			current = parent;
+			currentStatsStage = parentStage;
+		}
+	}
+
+private:
+	ClassStats * stats;
+	Stage stage;
+	StatsTimer * parent = nullptr;
+	int parentStage = STAGE_COUNT;
+	std::chrono::steady_clock::time_point start;
+	
+	static thread_local StatsTimer * current;
+};
+
+#define STATS_CONCAT2(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT2(a, b)
+
+#ifndef JDQ_NO_STATS
+#define STATS_SCOPE(stats) StatsScope STATS_CONCAT(statsScope, __LINE__)(stats)
+#define STATS_TIMER(stage) StatsTimer STATS_CONCAT(statsTimer, __LINE__)(stage)
+#define STATS_COUNT(counter, n) do { if(currentClassStats) currentClassStats->counters[counter] += (n); } while(0)
+#define STATS_OPCODES() (currentClassStats ? currentClassStats->opcodes : nullptr)
+#else
+#define STATS_SCOPE(stats) do {} while(0)
+#define STATS_TIMER(stage) do {} while(0)
+#define STATS_COUNT(counter, n) do {} while(0)
+#define STATS_OPCODES() static_cast<std::uint32_t *>(nullptr)
+#endif
+
+#endif
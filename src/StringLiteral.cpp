@@ -0,0 +1,223 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "StringLiteral.h"
+#include <algorithm>
+#include <cstring>
+
+// JDQ_NO_SIMD leaves only the lookup table
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(JDQ_NO_SIMD)
+#define JDQ_X86_SIMD
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// how each byte is written: 0 as it is, 'o' as an octal escape, 'u' when it
+// starts a UTF-8 sequence which may need a \u escape, else the letter after
+// the backslash
+struct LiteralEscapes
+{
+	char letters[256] = {};
+	
+	LiteralEscapes()
+	{
+		for(int c = 0;c < 0x20;c++)
+			letters[c] = 'o';
+		letters[0x7F] = 'o';
+		letters['\b'] = 'b';
+		letters['\f'] = 'f';
+		letters['\n'] = 'n';
+		letters['\r'] = 'r';
+		letters['\t'] = 't';
+		letters['"'] = '"';
+		letters['\\'] = '\\';
+		// U+0080 to U+009F, U+2028 and U+2029, the surrogates, U+FEFF to U+FFFF
+		letters[0xC2] = 'u';
+		letters[0xE2] = 'u';
+		letters[0xED] = 'u';
+		letters[0xEF] = 'u';
+	}
+};
+
+const LiteralEscapes literalEscapes;
+
+#ifdef JDQ_X86_SIMD
+
+// the bits of the 16 bytes at s which are not printable ASCII, a quote or a
+// backslash
+unsigned specialMask(const unsigned char * s)
+{
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+	// signed, so the bytes from 0x80 are below the space too
+	__m128i control = _mm_or_si128(_mm_cmplt_epi8(v, _mm_set1_epi8(0x20)), _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7F)));
+	__m128i quoted = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+	return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(control, quoted)));
+}
+
+#endif
+
+bool continuation(unsigned char c)
+{
+	return (c & 0xC0) == 0x80;
+}
+
+// the length of the sequence at s if it is one of the characters written
+// as \u escapes, else 0
+std::size_t hiddenCharacter(const unsigned char * s, std::size_t length, unsigned & code)
+{
+	if(s[0] == 0xC2)
+	{
+		if(length < 2 || s[1] < 0x80 || s[1] >= 0xA0)
+			return 0;
+		code = s[1];
+		return 2;
+	}
+	if(length < 3 || !continuation(s[1]) || !continuation(s[2]))
+		return 0;
+	code = (s[0] & 0x0Fu) << 12 | (s[1] & 0x3Fu) << 6 | (s[2] & 0x3Fu);
+	if(code == 0x2028 || code == 0x2029 || (code >= 0xD800 && code < 0xE000) || code == 0xFEFF || code >= 0xFFFE)
+		return 3;
+	return 0;
+}
+
+
+// the literal, written through a pointer: in a text full of quotes the
+// appends of std::string cost more than the rest of the escaping
+class LiteralBuffer
+{
+public:
+	LiteralBuffer(std::size_t length)
+	{
+		text.resize(length + length / 8 + 16);
+	}
+	
+	// room for count more bytes
+	char * reserve(std::size_t count)
+	{
+		if(used + count > text.size())
+			text.resize(std::max(text.size() * 2, used + count));
+		return &text[used];
+	}
+	
+	void commit(char * end)
+	{
+		used = end - &text[0];
+	}
+	
+	void append(const char * bytes, std::size_t count)
+	{
+		char * out = reserve(count);
+		std::memcpy(out, bytes, count);
+		commit(out + count);
+	}
+	
+	std::string take()
+	{
+		text.resize(used);
+		return std::move(text);
+	}
+
+private:
+	std::string text;
+	std::size_t used = 0;
+};
+
+// writes the text from run to i and the escape of the character at i, if it
+// needs one, and moves run past it
+void escape(LiteralBuffer & literal, const unsigned char * s, std::size_t length, std::size_t i, std::size_t & run)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	
+	char letter = literalEscapes.letters[s[i]];
+	if(!letter)
+		return;
+	
+	unsigned code = 0;
+	std::size_t sequence = 1;
+	if(letter == 'u')
+	{
+		sequence = hiddenCharacter(s + i, length - i, code);
+		if(!sequence)
+			return;
+	}
+	
+	char * out = literal.reserve(i - run + 6);
+	std::memcpy(out, s + run, i - run);
+	out += i - run;
+	*out++ = '\\';
+	if(letter == 'u')
+	{
+		*out++ = 'u';
+		for(int shift = 12;shift >= 0;shift -= 4)
+			*out++ = hex[code >> shift & 0xF];
+	}
+	else if(letter == 'o')
+	{
+		// always 3 digits, a digit after the escape can't extend it
+		*out++ = static_cast<char>('0' + (s[i] >> 6));
+		*out++ = static_cast<char>('0' + (s[i] >> 3 & 7));
+		*out++ = static_cast<char>('0' + (s[i] & 7));
+	}
+	else
+		*out++ = letter;
+	literal.commit(out);
+	run = i + sequence;
+}
+}
+
+std::string javaStringLiteral(const char * text, std::size_t length)
+{
+	const unsigned char * s = reinterpret_cast<const unsigned char *>(text);
+	LiteralBuffer literal(length);
+	literal.append("\"", 1);
+	std::size_t run = 0; // start of the bytes written as they are
+	std::size_t i = 0;
+#ifdef JDQ_X86_SIMD
+	// only the flagged bytes are looked at, so a long text with a few
+	// escapes costs about as much as copying it
+	for(;i + 16 <= length;i += 16)
+	{
+		for(unsigned mask = specialMask(s + i);mask;mask &= mask - 1)
+		{
+			std::size_t j = i + __builtin_ctz(mask);
+			if(j >= run) // else in a sequence already escaped
+				escape(literal, s, length, j, run);
+		}
+	}
+#endif
+	for(;i < length;i++)
+	{
+		if(i >= run && literalEscapes.letters[s[i]])
+			escape(literal, s, length, i, run);
+	}
+	literal.append(text + run, length - run);
+	literal.append("\"", 1);
+	return literal.take();
+}
+
+std::string javaStringLiteral(const std::string & text)
+{
+	return javaStringLiteral(text.data(), text.size());
+}
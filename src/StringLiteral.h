@@ -0,0 +1,39 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef STRINGLITERAL_H
+#define STRINGLITERAL_H
+
+#include <cstddef>
+#include <string>
+
+// the UTF-8 text as a Java string literal, quotes included: \" \\ \n and so
+// on, the other ASCII controls in octal (a \u000a would end the line before
+// javac sees the literal), and the invisible or unpaired characters (C1
+// controls, lone surrogates, U+2028, U+2029, U+FEFF, U+FFFE, U+FFFF) as \uXXXX;
+// the rest is copied as it is, a run at a time
+std::string javaStringLiteral(const char * text, std::size_t length);
+std::string javaStringLiteral(const std::string & text);
+
+#endif
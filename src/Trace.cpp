@@ -0,0 +1,163 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#include "Trace.h"
+#include "Json.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const std::size_t BUFFER_EVENTS = 1 << 15; // per thread
+const std::size_t NAME_LENGTH = 47; // longer names keep their tail, which tells classes and methods apart
+
+struct TraceEvent
+{
+	std::uint64_t start; // ns since the trace began
+	std::uint64_t duration;
+	const char * category;
+	char name[NAME_LENGTH + 1];
+};
+
+struct TraceBuffer
+{
+	std::vector<TraceEvent> events; // a ring once full
+	std::size_t next = 0;
+	std::uint64_t dropped = 0;
+	int tid;
+	std::string threadName;
+};
+
+std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+std::mutex buffersMutex;
+std::vector<std::unique_ptr<TraceBuffer>> buffers; // kept after their thread ends
+thread_local TraceBuffer * threadBuffer = nullptr;
+
+TraceBuffer & currentBuffer()
+{
+	if(!threadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffers.emplace_back(new TraceBuffer);
+		threadBuffer = buffers.back().get();
+		threadBuffer->tid = static_cast<int>(buffers.size());
+	}
+	return *threadBuffer;
+}
+
+void writeEvent(std::ostream & out, const TraceEvent & event, int tid)
+{
+	char times[64];
+	std::snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", event.start / 1e3, event.duration / 1e3);
+	out << "{\"name\":";
+	writeJsonString(out, event.name);
+	out << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\"," << times << ",\"pid\":1,\"tid\":" << tid << "}";
+}
+
+}
+
+bool traceRecording = false;
+
+void setTraceEnabled(bool enabled)
+{
+	if(enabled)
+		origin = std::chrono::steady_clock::now();
+	traceRecording = enabled;
+}
+
+void setTraceThreadName(const std::string & name)
+{
+	if(traceRecording)
+		currentBuffer().threadName = name;
+}
+
+std::uint64_t TraceScope::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void TraceScope::record(const char * category, const char * name, std::size_t length, std::uint64_t start, std::uint64_t duration)
+{
+	TraceBuffer & buffer = currentBuffer();
+	if(buffer.next >= BUFFER_EVENTS)
+		buffer.dropped++;
+	else
+		buffer.events.emplace_back(); // grows up to BUFFER_EVENTS, then wraps
+	
+	TraceEvent & event = buffer.events[buffer.next % BUFFER_EVENTS];
+	event.start = start;
+	event.duration = duration;
+	event.category = category;
+	if(length <= NAME_LENGTH)
+	{
+		std::memcpy(event.name, name, length);
+		event.name[length] = '\0';
+	}
+	else
+	{
+		// "..." and the tail, from the start of a UTF-8 character
+		const char * tail = name + length - (NAME_LENGTH - 3);
+		while(tail < name + length && (static_cast<unsigned char>(*tail) & 0xC0) == 0x80)
+			tail++;
+		std::memcpy(event.name, "...", 3);
+		std::memcpy(event.name + 3, tail, name + length - tail);
+		event.name[3 + (name + length - tail)] = '\0';
+	}
+	buffer.next++;
+}
+
+void writeTrace(std::ostream & out)
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	bool first = true;
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for(const auto & buffer : buffers)
+	{
+		if(!buffer->threadName.empty())
+		{
+			out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+			writeJsonString(out, buffer->threadName);
+			out << "}}";
+			first = false;
+		}
+		
+		// oldest first
+		std::size_t count = std::min(buffer->next, BUFFER_EVENTS);
+		for(std::size_t i = buffer->next - count;i < buffer->next;i++)
+		{
+			out << (first ? "" : ",\n");
+			writeEvent(out, buffer->events[i % BUFFER_EVENTS], buffer->tid);
+			first = false;
+		}
+	}
+	out << "\n],\"otherData\":{\"dropped_events\":\"";
+	std::uint64_t dropped = 0;
+	for(const auto & buffer : buffers)
+		dropped += buffer->dropped;
+	out << dropped << "\"}}\n";
+}
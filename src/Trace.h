@@ -0,0 +1,94 @@
+/*
+JDecomqiler
+
+Copyright (c) 2014 <Alexander Roper>
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+// begin/end of classes, methods and pipeline stages, written as Chrome
+// trace-event JSON (chrome://tracing, ui.perfetto.dev)
+// each thread records into its own fixed size ring buffer, without locking;
+// once it is full the oldest events are overwritten
+
+void setTraceEnabled(bool enabled);
+
+// names the calling thread in the trace
+void setTraceThreadName(const std::string & name);
+
+// to be called once the traced threads are done
+void writeTrace(std::ostream & out);
+
+extern bool traceRecording;
+
+class TraceScope
+{
+public:
+	TraceScope(const char * category, const char * name, std::size_t length)
+		: category(traceRecording ? category : nullptr), name(name), length(length)
+	{
+		if(this->category)
+			start = now();
+	}
+	
+	TraceScope(const char * category, const std::string & name)
+		: TraceScope(category, name.data(), name.size())
+	{
+	}
+	
+	TraceScope(const char * category, const char * name)
+		: TraceScope(category, name, std::strlen(name))
+	{
+	}
+	
+	~TraceScope()
+	{
+		if(category)
+			record(category, name, length, start, now() - start);
+	}
+
+private:
+	const char * category;
+	const char * name;
+	std::size_t length;
+	std::uint64_t start = 0;
+	
+	static std::uint64_t now();
+	static void record(const char * category, const char * name, std::size_t length, std::uint64_t start, std::uint64_t duration);
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+
+#ifndef JDQ_NO_STATS
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+#else
+#define TRACE_SCOPE(category, name) do {} while(0)
+#endif
+
+#endif
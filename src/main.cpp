@@ -22,18 +22,349 @@ freely, subject to the following restrictions:
    3. This notice may not be removed or altered from any source
    distribution.
 */
-#include "ClassFile.h"
+#include "JDecomqiler.h"
+#include "Batch.h"
+#include "Cache.h"
+#include "Diagnostics.h"
+#include "MethodMemo.h"
+#include "Profile.h"
+#include "Stats.h"
+#include "Trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <vector>
 
-int main(int argc, char** argv)
+static int usage(const char * name)
+{
+	std::cerr << "usage: " << name << " [options] <file.class>\n"
+	          << "       " << name << " [options] -d <output dir> <file.class|file.jar|dir>...\n"
+	          << "       " << name << " [options] --ndjson <file.class|file.jar|dir>...\n"
+	          << "       " << name << " --merge <output dir> <shard output dir>...\n"
+	          << "       " << name << " --profile [--profile-json <file>] <file.class|file.jar|dir>...\n"
+	          << "options:\n"
+	          << "  -q / -v                  same as --diagnostics off / info\n"
+	          << "  --diagnostics <level>    write the problems found in the classes as JSON lines on stderr:\n"
+	          << "                           off (default), error, warning, info or debug\n"
+	          << "  --diagnostics-file <file> write them to <file> instead\n"
+	          << "  -o <file>                output file when decompiling a single class (output.java)\n"
+	          << "  --format <format>        java (default), disasm for a javap -c like listing (.javap files),\n"
+	          << "                           json or ast for the decompiled model as JSON or binary\n"
+	          << "  -j <threads>             parsing and decompiling threads in batch mode (1)\n"
+	          << "  --queue-depth <classes>  classes waiting between two stages in batch mode (16)\n"
+	          << "  --shard <i>/<n>          only decompile the i-th of n shards in batch mode\n"
+	          << "  --ndjson                 batch mode writing one JSON record per class, output text included,\n"
+	          << "                           on stdout as soon as the class is done, instead of files\n"
+	          << "  --ordered                write the classes of a batch in input order\n"
+	          << "  --reorder-window <classes> with --ordered, most classes read ahead of the next one written (256)\n"
+	          << "  --cache <dir>            reuse the output of classes already decompiled\n"
+	          << "  --cache-size <bytes>     size limit of the cache, K/M/G suffixes allowed (1G)\n"
+	          << "  --memo                   reuse the output of identical methods\n"
+	          << "  --method-budget <limits> replace the methods going over the limits by stubs, the limits being\n"
+	          << "                           instructions=<n>,ms=<n>,bytes=<bytes> (any of them, none by default)\n"
+	          << "  --class-budget <limits>  same, for all the methods of a class together\n"
+	          << "  --stats                  print the time spent in each stage and other counters at the end\n"
+	          << "  --stats-json <file>      write the same statistics as JSON\n"
+	          << "  --trace <file>           write the classes, methods and stages run by each thread as a Chrome trace\n";
+	return 1;
+}
+
+static std::uint64_t parseSize(const char * str)
+{
+	char * end;
+	std::uint64_t size = std::strtoull(str, &end, 10);
+	switch(*end)
+	{
+		case 'G': size <<= 10; // fallthrough
+		case 'M': size <<= 10; // fallthrough
+		case 'K': size <<= 10;
+	}
+	return size;
+}
+
+// "instructions=<n>,ms=<n>,bytes=<bytes>", in any order and any subset
+static bool parseBudget(const char * str, Budget & budget)
 {
-   if (argc != 2)
-   {
-      std::cerr << "usage: " << argv[0] << " <file.class>\n";
-      return 1;
-   }
-
-	ClassFile cf(argv[1]);
-	cf.generate();
+	std::string spec = str;
+	std::size_t pos = 0;
+	while (pos < spec.size())
+	{
+		std::size_t comma = spec.find(',', pos);
+		if (comma == std::string::npos)
+			comma = spec.size();
+		std::string limit = spec.substr(pos, comma - pos);
+		pos = comma + 1;
+		
+		std::size_t equal = limit.find('=');
+		if (equal == std::string::npos || equal + 1 == limit.size())
+			return false;
+		std::string key = limit.substr(0, equal);
+		const char * value = limit.c_str() + equal + 1;
+		if (key == "instructions")
+			budget.instructions = std::strtoull(value, nullptr, 10);
+		else if (key == "ms")
+			budget.milliseconds = std::strtoull(value, nullptr, 10);
+		else if (key == "bytes")
+			budget.bytes = parseSize(value);
+		else
+			return false;
+	}
+	return true;
+}
+
+static int decompileOne(const char * input, const char * output, const DecompileOptions & options)
+{
+	std::ifstream file(input, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "can't open " << input << "\n";
+		return 1;
+	}
+	TRACE_SCOPE("decompile", input);
+	ClassStats stats;
+	STATS_SCOPE(statsEnabled() ? &stats : nullptr);
+	
+	std::vector<std::uint8_t> data;
+	{
+		STATS_TIMER(STAGE_READ);
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	
+	std::ofstream out(output);
+	if (!out.is_open())
+	{
+		std::cerr << "can't write " << output << "\n";
+		return 1;
+	}
+	StreamSink sink(out);
+	
+	DecompileStatus status = decompile(data.data(), data.size(), options, sink);
+	if (statsEnabled())
+		addClassStats(stats, input);
+	if (status == DECOMPILE_INVALID_CLASS)
+	{
+		std::cerr << input << " is not a valid class file\n";
+		return 1;
+	}
 	return 0;
 }
+
+int main(int argc, char** argv)
+{
+	BatchOptions batch;
+	DecompileOptions & options = batch.decompile;
+	int diagnostics = DIAG_OFF;
+	const char * diagnosticsFile = nullptr;
+	const char * output = nullptr; // output.java, output.javap...
+	const char * cacheDirectory = nullptr;
+	std::uint64_t cacheSize = 1ULL << 30;
+	bool memo = false;
+	bool stats = false;
+	const char * statsJson = nullptr;
+	const char * trace = nullptr;
+	const char * merge = nullptr;
+	bool profile = false;
+	const char * profileJson = nullptr;
+	
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "-q") == 0)
+			diagnostics = DIAG_OFF;
+		else if (std::strcmp(argv[i], "-v") == 0)
+			diagnostics = DIAG_INFO;
+		else if (std::strcmp(argv[i], "--diagnostics") == 0 && hasValue)
+		{
+			if (!parseDiagnosticsLevel(argv[++i], diagnostics))
+				return usage(argv[0]);
+		}
+		else if (std::strcmp(argv[i], "--diagnostics-file") == 0 && hasValue)
+			diagnosticsFile = argv[++i];
+		else if (std::strcmp(argv[i], "-o") == 0 && hasValue)
+			output = argv[++i];
+		else if (std::strcmp(argv[i], "-d") == 0 && hasValue)
+			batch.outputDirectory = argv[++i];
+		else if (std::strcmp(argv[i], "-j") == 0 && hasValue)
+			batch.jobs = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--queue-depth") == 0 && hasValue)
+			batch.queueDepth = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--ndjson") == 0)
+			batch.ndjson = true;
+		else if (std::strcmp(argv[i], "--ordered") == 0)
+			batch.ordered = true;
+		else if (std::strcmp(argv[i], "--reorder-window") == 0 && hasValue)
+			batch.reorderWindow = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--shard") == 0 && hasValue)
+		{
+			if (std::sscanf(argv[++i], "%d/%d", &batch.shardIndex, &batch.shardCount) != 2
+				|| batch.shardCount < 1 || batch.shardIndex < 0 || batch.shardIndex >= batch.shardCount)
+				return usage(argv[0]);
+		}
+		else if (std::strcmp(argv[i], "--merge") == 0 && hasValue)
+			merge = argv[++i];
+		else if (std::strcmp(argv[i], "--profile") == 0)
+			profile = true;
+		else if (std::strcmp(argv[i], "--profile-json") == 0 && hasValue)
+		{
+			profile = true;
+			profileJson = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--format") == 0 && hasValue)
+		{
+			if (!parseOutputFormat(argv[++i], options.format))
+				return usage(argv[0]);
+		}
+		else if (std::strcmp(argv[i], "--cache") == 0 && hasValue)
+			cacheDirectory = argv[++i];
+		else if (std::strcmp(argv[i], "--cache-size") == 0 && hasValue)
+			cacheSize = parseSize(argv[++i]);
+		else if (std::strcmp(argv[i], "--memo") == 0)
+			memo = true;
+		else if (std::strcmp(argv[i], "--method-budget") == 0 && hasValue)
+		{
+			if (!parseBudget(argv[++i], options.methodBudget))
+				return usage(argv[0]);
+		}
+		else if (std::strcmp(argv[i], "--class-budget") == 0 && hasValue)
+		{
+			if (!parseBudget(argv[++i], options.classBudget))
+				return usage(argv[0]);
+		}
+		else if (std::strcmp(argv[i], "--stats") == 0)
+			stats = true;
+		else if (std::strcmp(argv[i], "--stats-json") == 0 && hasValue)
+			statsJson = argv[++i];
+		else if (std::strcmp(argv[i], "--trace") == 0 && hasValue)
+			trace = argv[++i];
+		else if (argv[i][0] != '-')
+			batch.inputs.push_back(argv[i]);
+		else
+			return usage(argv[0]);
+	}
+	
+	std::ofstream diagnosticsOutput;
+	if (diagnosticsFile)
+	{
+		diagnosticsOutput.open(diagnosticsFile, std::ios::out | std::ios::trunc);
+		if (!diagnosticsOutput.is_open())
+			std::cerr << "can't write " << diagnosticsFile << "\n";
+		else
+			setDiagnosticsOutput(&diagnosticsOutput);
+	}
+	setDiagnosticsLevel(diagnostics);
+	
+	if (merge)
+	{
+		BatchResult result = mergeShards(merge, batch.inputs);
+		flushDiagnostics();
+		if (stats)
+			std::cerr << "classes: " << result.classes << ", failed: " << result.failed << "\n";
+		return result.failed > 0 ? 1 : 0;
+	}
+	
+	if (profile)
+	{
+		if (batch.inputs.empty())
+			return usage(argv[0]);
+		
+		std::unique_ptr<Profile> corpus(new Profile);
+		std::uint64_t failed = corpus->addInputs(batch.inputs);
+		flushDiagnostics();
+		if (profileJson)
+		{
+			std::ofstream json(profileJson, std::ios::out | std::ios::trunc);
+			if (!json.is_open())
+				std::cerr << "can't write " << profileJson << "\n";
+			corpus->writeJson(json);
+		}
+		else
+		{
+			corpus->print(std::cout);
+		}
+		return failed > 0 ? 1 : 0;
+	}
+	
+	bool isBatch = !batch.outputDirectory.empty() || batch.ndjson;
+	if (batch.inputs.empty() || (!isBatch && batch.inputs.size() > 1))
+		return usage(argv[0]);
+	// the records are text, and go where the files would
+	if (batch.ndjson && (options.format == FORMAT_AST || !batch.outputDirectory.empty()))
+		return usage(argv[0]);
+	
+	std::unique_ptr<DecompileCache> cache;
+	if (cacheDirectory)
+	{
+		cache.reset(new DecompileCache(cacheDirectory, cacheSize));
+		if (!cache->isOpen())
+			std::cerr << "can't use " << cacheDirectory << " as cache, ignored\n";
+		options.cache = cache.get();
+	}
+	
+	MethodMemo methodMemo;
+	if (memo)
+		options.methodMemo = &methodMemo;
+	
+	setStatsEnabled(stats || statsJson);
+	if ((stats || statsJson) && !statsEnabled())
+		std::cerr << "built with NO_STATS=1, only the totals are available\n";
+	if (trace)
+	{
+		setTraceEnabled(true);
+		setTraceThreadName(isBatch ? "write" : "main");
+	}
+	
+	int ret = 0;
+	std::map<std::string, std::uint64_t> extra;
+	if (isBatch)
+	{
+		if (!batch.ndjson)
+			batch.manifest = batch.outputDirectory + "/manifest.jsonl";
+		BatchResult result = runBatch(batch);
+		extra["failed"] = result.failed;
+		extra["partial"] = result.partial;
+		ret = result.failed > 0 ? 1 : 0;
+	}
+	else
+	{
+		std::string defaultOutput = std::string("output") + outputExtension(options.format);
+		ret = decompileOne(batch.inputs[0].c_str(), output ? output : defaultOutput.c_str(), options);
+	}
+	
+	// the batch threads flushed theirs when they ended
+	flushDiagnostics();
+	setDiagnosticsOutput(&std::cerr);
+	
+	if (memo)
+	{
+		extra["memo_lookups"] = methodMemo.lookups();
+		extra["memo_hits"] = methodMemo.hits();
+	}
+	
+	RunStats totals = runStats();
+	if (stats)
+	{
+		printStats(std::cerr, totals, extra);
+		if (memo && methodMemo.lookups() > 0)
+			std::cerr << "method memo hit rate: " << (100.0 * methodMemo.hits() / methodMemo.lookups()) << "%\n";
+	}
+	if (statsJson)
+	{
+		std::ofstream json(statsJson, std::ios::out | std::ios::trunc);
+		if (!json.is_open())
+			std::cerr << "can't write " << statsJson << "\n";
+		writeStatsJson(json, totals, extra);
+	}
+	if (trace)
+	{
+		std::ofstream json(trace, std::ios::out | std::ios::trunc);
+		if (!json.is_open())
+			std::cerr << "can't write " << trace << "\n";
+		writeTrace(json);
+	}
+	return ret;
+}